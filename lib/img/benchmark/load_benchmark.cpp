@@ -0,0 +1,70 @@
+// Measures how fast img can decode all the images in a folder, one after the other and then with img::load_many().
+// Usage: img_load_benchmark <folder> [threads_count]
+
+#include <img/img.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static auto is_image(std::filesystem::path const& path) -> bool
+{
+    auto extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" || extension == ".tga" || extension == ".gif" || extension == ".psd" || extension == ".pnm" || extension == ".ppm" || extension == ".pgm";
+}
+
+static void print_results(std::string const& name, std::chrono::duration<double> duration, size_t images_count, size_t files_size, size_t pixels_size)
+{
+    auto const seconds = duration.count();
+    std::cout << name << ": " << seconds * 1000. << " ms, "
+              << static_cast<double>(images_count) / seconds << " images/s, "
+              << static_cast<double>(files_size) / seconds / 1e6 << " MB/s read, "
+              << static_cast<double>(pixels_size) / seconds / 1e6 << " MB/s decoded\n";
+}
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <folder> [threads_count]\n";
+        return EXIT_FAILURE;
+    }
+    auto const threads_count = argc >= 3 ? static_cast<size_t>(std::stoul(argv[2])) : size_t{0};
+
+    auto   paths      = std::vector<std::filesystem::path>{};
+    size_t files_size = 0;
+    for (auto const& entry : std::filesystem::recursive_directory_iterator{argv[1]})
+    {
+        if (entry.is_regular_file() && is_image(entry.path()))
+        {
+            paths.push_back(entry.path());
+            files_size += static_cast<size_t>(entry.file_size());
+        }
+    }
+    if (paths.empty())
+    {
+        std::cerr << "No image found in " << argv[1] << '\n';
+        return EXIT_FAILURE;
+    }
+    std::cout << paths.size() << " images, " << static_cast<double>(files_size) / 1e6 << " MB\n";
+
+    size_t pixels_size = 0;
+    {
+        auto const begin = std::chrono::steady_clock::now();
+        for (auto const& path : paths)
+            pixels_size += img::load(path, img::LoadOptions{}).data_size();
+        print_results("img::load (sequential)", std::chrono::steady_clock::now() - begin, paths.size(), files_size, pixels_size);
+    }
+    {
+        auto const begin = std::chrono::steady_clock::now();
+        auto       batch = img::load_many(paths, {}, threads_count);
+        for (auto& future : batch.images)
+            future.get();
+        print_results("img::load_many", std::chrono::steady_clock::now() - begin, paths.size(), files_size, pixels_size);
+    }
+    return EXIT_SUCCESS;
+}
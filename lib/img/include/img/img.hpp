@@ -2,6 +2,8 @@
 
 #include "../../src/Image.h"
 #include "../../src/Load.h"
+#include "../../src/MappedFile.h"
+#include "../../src/Operations.h"
 #include "../../src/Save.h"
 #include "../../src/Size.h"
 #include "../../src/SizeU.h"
\ No newline at end of file
@@ -0,0 +1,734 @@
+#include "Deflate.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <numeric>
+#include <queue>
+#include "Parallel.h"
+
+namespace img::internal {
+
+namespace {
+
+constexpr size_t   window_size{32768};
+constexpr size_t   min_match_length{3};
+constexpr size_t   max_match_length{258};
+constexpr size_t   max_tokens_per_block{16384};
+constexpr size_t   max_stored_block_size{65535};
+constexpr size_t   piece_size{256 * 1024}; // Amount of input compressed by each job in zlib_compress_pieces()
+constexpr uint32_t hash_bits{15};
+
+constexpr size_t litlen_symbols_count{286};
+constexpr size_t dist_symbols_count{30};
+constexpr size_t code_length_symbols_count{19};
+constexpr int    max_code_length{15};
+constexpr int    max_code_length_code_length{7};
+
+constexpr std::array<uint16_t, 29> length_base{3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<uint8_t, 29>  length_extra_bits{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<uint16_t, 30> dist_base{1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::array<uint8_t, 30>  dist_extra_bits{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr std::array<uint8_t, 19>  code_length_order{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+struct LevelParams {
+    int    max_chain_length;
+    size_t nice_length; // Stop searching as soon as we find a match that long
+    bool   lazy_matching;
+};
+
+constexpr std::array<LevelParams, 10> level_params{{
+    {0, 0, false}, // Level 0 is never used to search matches, we emit stored blocks
+    {4, 8, false},
+    {8, 16, false},
+    {16, 32, false},
+    {16, 32, true},
+    {32, 64, true},
+    {128, 128, true},
+    {256, 258, true},
+    {1024, 258, true},
+    {4096, 258, true},
+}};
+
+/// A literal if distance == 0, a match otherwise.
+struct Token {
+    uint16_t literal_or_length;
+    uint16_t distance;
+};
+
+struct SymbolCode {
+    uint16_t code;   // Already bit-reversed, ready to be written LSB-first
+    uint8_t  length; // In bits
+};
+
+auto length_symbol_index(size_t length) -> size_t
+{
+    static auto const table = []() {
+        auto res = std::array<uint8_t, max_match_length + 1>{};
+        for (size_t i = 0; i < length_base.size(); ++i)
+        {
+            auto const end = i + 1 < length_base.size() ? size_t{length_base[i + 1]} : size_t{length_base[i]} + 1;
+            for (size_t length = length_base[i]; length < end && length <= max_match_length; ++length)
+                res[length] = static_cast<uint8_t>(i);
+        }
+        res[max_match_length] = static_cast<uint8_t>(length_base.size() - 1); // 258 has its own code, even though 227 + 5 extra bits could represent it
+        return res;
+    }();
+    return table[length];
+}
+
+auto dist_symbol_index(size_t distance) -> size_t
+{
+    return static_cast<size_t>(std::upper_bound(dist_base.begin(), dist_base.end(), distance) - dist_base.begin()) - 1;
+}
+
+auto reverse_bits(uint32_t code, int length) -> uint16_t
+{
+    uint32_t res = 0;
+    for (int i = 0; i < length; ++i)
+    {
+        res  = (res << 1) | (code & 1);
+        code >>= 1;
+    }
+    return static_cast<uint16_t>(res);
+}
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& output)
+        : _output{output}
+    {}
+
+    void write(uint32_t bits, int bits_count)
+    {
+        assert(bits_count <= 32);
+        _buffer |= static_cast<uint64_t>(bits) << _bits_count;
+        _bits_count += bits_count;
+        while (_bits_count >= 8)
+        {
+            _output.push_back(static_cast<uint8_t>(_buffer));
+            _buffer >>= 8;
+            _bits_count -= 8;
+        }
+    }
+
+    void write(SymbolCode code) { write(code.code, code.length); }
+
+    void align_to_byte()
+    {
+        if (_bits_count > 0)
+            write(0, 8 - _bits_count);
+    }
+
+    /// Only valid when the writer is aligned to a byte
+    void write_bytes(std::span<uint8_t const> bytes)
+    {
+        assert(_bits_count == 0);
+        _output.insert(_output.end(), bytes.begin(), bytes.end());
+    }
+
+private:
+    std::vector<uint8_t>& _output; // NOLINT(*avoid-const-or-ref-data-members)
+    uint64_t              _buffer{0};
+    int                   _bits_count{0};
+};
+
+/// Computes the length of the Huffman code of each symbol, such that no code is longer than max_length.
+void build_code_lengths(std::span<uint32_t const> frequencies, int max_length, std::span<uint8_t> lengths)
+{
+    std::fill(lengths.begin(), lengths.end(), uint8_t{0});
+
+    auto symbols = std::vector<size_t>{};
+    for (size_t i = 0; i < frequencies.size(); ++i)
+    {
+        if (frequencies[i] != 0)
+            symbols.push_back(i);
+    }
+    if (symbols.empty())
+        return;
+    if (symbols.size() == 1)
+    {
+        lengths[symbols[0]] = 1;
+        return;
+    }
+
+    // Build the Huffman tree. Leaves are the first nodes, internal nodes come after.
+    auto parents = std::vector<size_t>(2 * symbols.size() - 1);
+    {
+        using Node = std::pair<uint64_t, size_t>; // (frequency, index)
+        auto queue = std::priority_queue<Node, std::vector<Node>, std::greater<>>{};
+        for (size_t i = 0; i < symbols.size(); ++i)
+            queue.emplace(frequencies[symbols[i]], i);
+        size_t next_node = symbols.size();
+        while (queue.size() > 1)
+        {
+            auto const a = queue.top();
+            queue.pop();
+            auto const b = queue.top();
+            queue.pop();
+            parents[a.second] = next_node;
+            parents[b.second] = next_node;
+            queue.emplace(a.first + b.first, next_node);
+            ++next_node;
+        }
+    }
+    // Parents always come after their children, so we can compute the depths from the root down
+    auto depths = std::vector<int>(parents.size(), 0);
+    for (size_t node = parents.size() - 1; node-- > 0;)
+        depths[node] = depths[parents[node]] + 1;
+
+    // Count the leaves at each depth, and make sure none is deeper than max_length (while keeping the Kraft inequality satisfied)
+    auto counts = std::vector<uint32_t>(static_cast<size_t>(max_length) + 1, 0);
+    for (size_t i = 0; i < symbols.size(); ++i)
+        ++counts[static_cast<size_t>(std::min(depths[i], max_length))];
+    uint64_t total = 0;
+    for (int length = 1; length <= max_length; ++length)
+        total += static_cast<uint64_t>(counts[static_cast<size_t>(length)]) << (max_length - length);
+    while (total > (uint64_t{1} << max_length))
+    {
+        --counts[static_cast<size_t>(max_length)];
+        for (int length = max_length - 1; length > 0; --length)
+        {
+            if (counts[static_cast<size_t>(length)] != 0)
+            {
+                --counts[static_cast<size_t>(length)];
+                counts[static_cast<size_t>(length) + 1] += 2;
+                break;
+            }
+        }
+        --total;
+    }
+
+    // The most frequent symbols get the shortest codes
+    std::stable_sort(symbols.begin(), symbols.end(), [&](size_t a, size_t b) { return frequencies[a] > frequencies[b]; });
+    size_t symbol_index = 0;
+    for (int length = 1; length <= max_length; ++length)
+    {
+        for (uint32_t i = 0; i < counts[static_cast<size_t>(length)]; ++i)
+            lengths[symbols[symbol_index++]] = static_cast<uint8_t>(length);
+    }
+}
+
+void build_codes(std::span<uint8_t const> lengths, std::span<SymbolCode> codes)
+{
+    auto counts = std::array<uint32_t, max_code_length + 1>{};
+    for (auto const length : lengths)
+        ++counts[length];
+    counts[0] = 0;
+    auto     next_code = std::array<uint32_t, max_code_length + 2>{};
+    uint32_t code      = 0;
+    for (size_t length = 1; length <= max_code_length; ++length)
+    {
+        code                  = (code + counts[length - 1]) << 1;
+        next_code[length]     = code;
+    }
+    for (size_t i = 0; i < lengths.size(); ++i)
+    {
+        if (lengths[i] != 0)
+            codes[i] = {.code = reverse_bits(next_code[lengths[i]]++, lengths[i]), .length = lengths[i]};
+        else
+            codes[i] = {.code = 0, .length = 0};
+    }
+}
+
+/// A code length symbol, and the value of its extra bits (only for symbols 16, 17 and 18)
+struct CodeLengthToken {
+    uint8_t symbol;
+    uint8_t extra;
+};
+
+/// Run-length encodes the code lengths, as described in section 3.2.7 of RFC 1951
+auto run_length_encode(std::span<uint8_t const> lengths) -> std::vector<CodeLengthToken>
+{
+    auto   res = std::vector<CodeLengthToken>{};
+    size_t i   = 0;
+    while (i < lengths.size())
+    {
+        auto const length = lengths[i];
+        size_t     run    = 1;
+        while (i + run < lengths.size() && lengths[i + run] == length)
+            ++run;
+        i += run;
+        if (length == 0)
+        {
+            while (run >= 11)
+            {
+                auto const n = std::min(run, size_t{138});
+                res.push_back({18, static_cast<uint8_t>(n - 11)});
+                run -= n;
+            }
+            if (run >= 3)
+            {
+                res.push_back({17, static_cast<uint8_t>(run - 3)});
+                run = 0;
+            }
+        }
+        else
+        {
+            res.push_back({length, 0});
+            --run;
+            while (run >= 3)
+            {
+                auto const n = std::min(run, size_t{6});
+                res.push_back({16, static_cast<uint8_t>(n - 3)});
+                run -= n;
+            }
+        }
+        for (; run > 0; --run)
+            res.push_back({length, 0});
+    }
+    return res;
+}
+
+auto code_length_extra_bits(uint8_t symbol) -> int
+{
+    switch (symbol)
+    {
+    case 16: return 2;
+    case 17: return 3;
+    case 18: return 7;
+    default: return 0;
+    }
+}
+
+auto fixed_litlen_lengths() -> std::array<uint8_t, 288> const&
+{
+    static auto const lengths = []() {
+        auto res = std::array<uint8_t, 288>{};
+        std::fill(res.begin(), res.begin() + 144, uint8_t{8});
+        std::fill(res.begin() + 144, res.begin() + 256, uint8_t{9});
+        std::fill(res.begin() + 256, res.begin() + 280, uint8_t{7});
+        std::fill(res.begin() + 280, res.end(), uint8_t{8});
+        return res;
+    }();
+    return lengths;
+}
+
+auto fixed_dist_lengths() -> std::array<uint8_t, 32> const&
+{
+    static auto const lengths = []() {
+        auto res = std::array<uint8_t, 32>{};
+        res.fill(5);
+        return res;
+    }();
+    return lengths;
+}
+
+class BlockWriter {
+public:
+    BlockWriter(std::vector<uint8_t>& output)
+        : _bits{output}
+    {}
+
+    /// Writes the tokens (which represent raw_bytes) using whichever of the stored, fixed or dynamic block types is the smallest.
+    void write_block(std::span<Token const> tokens, std::span<uint8_t const> raw_bytes, bool is_final)
+    {
+        auto litlen_frequencies = std::array<uint32_t, litlen_symbols_count>{};
+        auto dist_frequencies   = std::array<uint32_t, dist_symbols_count>{};
+        for (auto const& token : tokens)
+        {
+            if (token.distance == 0)
+            {
+                ++litlen_frequencies[token.literal_or_length];
+            }
+            else
+            {
+                ++litlen_frequencies[257 + length_symbol_index(token.literal_or_length)];
+                ++dist_frequencies[dist_symbol_index(token.distance)];
+            }
+        }
+        litlen_frequencies[256] = 1; // End of block
+
+        // Dynamic block
+        auto litlen_lengths = std::array<uint8_t, litlen_symbols_count>{};
+        auto dist_lengths   = std::array<uint8_t, dist_symbols_count>{};
+        build_code_lengths(litlen_frequencies, max_code_length, litlen_lengths);
+        if (std::all_of(dist_frequencies.begin(), dist_frequencies.end(), [](uint32_t f) { return f == 0; }))
+            dist_lengths[0] = 1; // We need to describe at least one distance code
+        else
+            build_code_lengths(dist_frequencies, max_code_length, dist_lengths);
+
+        size_t litlen_count = litlen_symbols_count;
+        while (litlen_count > 257 && litlen_lengths[litlen_count - 1] == 0)
+            --litlen_count;
+        size_t dist_count = dist_symbols_count;
+        while (dist_count > 1 && dist_lengths[dist_count - 1] == 0)
+            --dist_count;
+
+        auto all_lengths = std::vector<uint8_t>(litlen_lengths.begin(), litlen_lengths.begin() + static_cast<std::ptrdiff_t>(litlen_count));
+        all_lengths.insert(all_lengths.end(), dist_lengths.begin(), dist_lengths.begin() + static_cast<std::ptrdiff_t>(dist_count));
+        auto const code_length_tokens      = run_length_encode(all_lengths);
+        auto       code_length_frequencies = std::array<uint32_t, code_length_symbols_count>{};
+        for (auto const& token : code_length_tokens)
+            ++code_length_frequencies[token.symbol];
+        auto code_length_lengths = std::array<uint8_t, code_length_symbols_count>{};
+        build_code_lengths(code_length_frequencies, max_code_length_code_length, code_length_lengths);
+        size_t code_length_count = code_length_symbols_count;
+        while (code_length_count > 4 && code_length_lengths[code_length_order[code_length_count - 1]] == 0)
+            --code_length_count;
+
+        uint64_t dynamic_size = 3 + 5 + 5 + 4 + 3 * code_length_count;
+        for (auto const& token : code_length_tokens)
+            dynamic_size += code_length_lengths[token.symbol] + static_cast<uint64_t>(code_length_extra_bits(token.symbol));
+        dynamic_size += data_size(litlen_frequencies, dist_frequencies, litlen_lengths, dist_lengths);
+
+        uint64_t const fixed_size  = 3 + data_size(litlen_frequencies, dist_frequencies, fixed_litlen_lengths(), fixed_dist_lengths());
+        uint64_t const stored_size = (raw_bytes.size() / max_stored_block_size + 1) * (3 + 7 + 32) + 8 * static_cast<uint64_t>(raw_bytes.size());
+
+        if (stored_size <= fixed_size && stored_size <= dynamic_size)
+        {
+            write_stored_blocks(raw_bytes, is_final);
+        }
+        else if (fixed_size <= dynamic_size)
+        {
+            _bits.write(is_final ? 1 : 0, 1);
+            _bits.write(1, 2);
+            write_tokens(tokens, fixed_litlen_lengths(), fixed_dist_lengths());
+        }
+        else
+        {
+            _bits.write(is_final ? 1 : 0, 1);
+            _bits.write(2, 2);
+            _bits.write(static_cast<uint32_t>(litlen_count - 257), 5);
+            _bits.write(static_cast<uint32_t>(dist_count - 1), 5);
+            _bits.write(static_cast<uint32_t>(code_length_count - 4), 4);
+            for (size_t i = 0; i < code_length_count; ++i)
+                _bits.write(code_length_lengths[code_length_order[i]], 3);
+            auto code_length_codes = std::array<SymbolCode, code_length_symbols_count>{};
+            build_codes(code_length_lengths, code_length_codes);
+            for (auto const& token : code_length_tokens)
+            {
+                _bits.write(code_length_codes[token.symbol]);
+                _bits.write(token.extra, code_length_extra_bits(token.symbol));
+            }
+            write_tokens(tokens, litlen_lengths, dist_lengths);
+        }
+    }
+
+    void write_stored_blocks(std::span<uint8_t const> raw_bytes, bool is_final)
+    {
+        size_t offset = 0;
+        do
+        {
+            auto const size     = std::min(raw_bytes.size() - offset, max_stored_block_size);
+            auto const is_last  = offset + size == raw_bytes.size();
+            auto const length   = static_cast<uint16_t>(size);
+            auto const nlength  = static_cast<uint16_t>(~length);
+            auto const header   = std::array<uint8_t, 4>{static_cast<uint8_t>(length & 0xFF), static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(nlength & 0xFF), static_cast<uint8_t>(nlength >> 8)};
+            _bits.write(is_final && is_last ? 1 : 0, 1);
+            _bits.write(0, 2);
+            _bits.align_to_byte();
+            _bits.write_bytes(header);
+            _bits.write_bytes(raw_bytes.subspan(offset, size));
+            offset += size;
+        } while (offset < raw_bytes.size());
+    }
+
+    /// Ends a non-final piece of the stream with an empty stored block, so that the output is byte-aligned (this is what zlib calls a sync flush)
+    void write_sync_flush()
+    {
+        write_stored_blocks({}, false);
+    }
+
+    void finish() { _bits.align_to_byte(); }
+
+private:
+    template<typename LitLenLengths, typename DistLengths>
+    static auto data_size(std::array<uint32_t, litlen_symbols_count> const& litlen_frequencies, std::array<uint32_t, dist_symbols_count> const& dist_frequencies, LitLenLengths const& litlen_lengths, DistLengths const& dist_lengths) -> uint64_t
+    {
+        uint64_t size = 0;
+        for (size_t i = 0; i < litlen_symbols_count; ++i)
+        {
+            size += static_cast<uint64_t>(litlen_frequencies[i]) * litlen_lengths[i];
+            if (i >= 257)
+                size += static_cast<uint64_t>(litlen_frequencies[i]) * length_extra_bits[i - 257];
+        }
+        for (size_t i = 0; i < dist_symbols_count; ++i)
+            size += static_cast<uint64_t>(dist_frequencies[i]) * (dist_lengths[i] + dist_extra_bits[i]);
+        return size;
+    }
+
+    void write_tokens(std::span<Token const> tokens, std::span<uint8_t const> litlen_lengths, std::span<uint8_t const> dist_lengths)
+    {
+        auto litlen_codes = std::array<SymbolCode, 288>{};
+        auto dist_codes   = std::array<SymbolCode, 32>{};
+        build_codes(litlen_lengths, std::span{litlen_codes}.first(litlen_lengths.size()));
+        build_codes(dist_lengths, std::span{dist_codes}.first(dist_lengths.size()));
+        for (auto const& token : tokens)
+        {
+            if (token.distance == 0)
+            {
+                _bits.write(litlen_codes[token.literal_or_length]);
+                continue;
+            }
+            auto const length_index = length_symbol_index(token.literal_or_length);
+            _bits.write(litlen_codes[257 + length_index]);
+            _bits.write(token.literal_or_length - length_base[length_index], length_extra_bits[length_index]);
+            auto const dist_index = dist_symbol_index(token.distance);
+            _bits.write(dist_codes[dist_index]);
+            _bits.write(token.distance - dist_base[dist_index], dist_extra_bits[dist_index]);
+        }
+        _bits.write(litlen_codes[256]); // End of block
+    }
+
+private:
+    BitWriter _bits;
+};
+
+/// Finds repeated sequences with hash chains, like zlib does.
+class MatchFinder {
+public:
+    explicit MatchFinder(std::span<uint8_t const> input)
+        : _input{input}
+        , _head(size_t{1} << hash_bits, -1)
+        , _previous(window_size, -1)
+    {}
+
+    void insert(size_t position)
+    {
+        if (position + min_match_length > _input.size())
+            return;
+        auto const hash                               = hash_at(position);
+        _previous[position & (window_size - 1)]       = _head[hash];
+        _head[hash]                                   = static_cast<int32_t>(position);
+    }
+
+    /// Returns (length, distance) of the longest match for the bytes starting at position. length is 0 if there is no match.
+    auto longest_match(size_t position, LevelParams const& params) const -> std::pair<size_t, size_t>
+    {
+        auto const max_length = std::min(max_match_length, _input.size() - position);
+        if (max_length < min_match_length)
+            return {0, 0};
+
+        size_t best_length   = min_match_length - 1;
+        size_t best_distance = 0;
+        auto   candidate     = _head[hash_at(position)];
+        int    chain_length  = params.max_chain_length;
+        while (candidate >= 0 && chain_length-- > 0)
+        {
+            auto const candidate_position = static_cast<size_t>(candidate);
+            if (candidate_position >= position || position - candidate_position > window_size)
+                break;
+            if (_input[candidate_position + best_length] == _input[position + best_length])
+            {
+                size_t length = 0;
+                while (length < max_length && _input[candidate_position + length] == _input[position + length])
+                    ++length;
+                if (length > best_length)
+                {
+                    best_length   = length;
+                    best_distance = position - candidate_position;
+                    if (length >= params.nice_length || length == max_length)
+                        break;
+                }
+            }
+            auto const next = _previous[candidate_position & (window_size - 1)];
+            if (next >= candidate)
+                break;
+            candidate = next;
+        }
+        if (best_distance == 0)
+            return {0, 0};
+        return {best_length, best_distance};
+    }
+
+private:
+    auto hash_at(size_t position) const -> size_t
+    {
+        uint32_t const bytes = static_cast<uint32_t>(_input[position]) | (static_cast<uint32_t>(_input[position + 1]) << 8) | (static_cast<uint32_t>(_input[position + 2]) << 16);
+        return (bytes * 2654435761u) >> (32 - hash_bits);
+    }
+
+private:
+    std::span<uint8_t const> _input;
+    std::vector<int32_t>     _head;
+    std::vector<int32_t>     _previous;
+};
+
+} // namespace
+
+auto deflate(std::span<uint8_t const> input, size_t start, int level, bool is_last) -> std::vector<uint8_t>
+{
+    assert(start <= input.size());
+    // Positions are stored on 32 bits in the MatchFinder, and we only ever need the last window of history
+    if (start > window_size)
+    {
+        input = input.subspan(start - window_size);
+        start = window_size;
+    }
+    assert(input.size() < (size_t{1} << 31) && "Split your data into smaller pieces, like zlib_compress_pieces() does.");
+
+    level                   = std::clamp(level, 0, 9);
+    auto const input_size   = input.size() - start;
+    auto       output       = std::vector<uint8_t>{};
+    output.reserve(level == 0 ? input_size + 5 * (input_size / max_stored_block_size + 2) : input_size / 2 + 64);
+    auto writer = BlockWriter{output};
+
+    if (level == 0)
+    {
+        writer.write_stored_blocks(input.subspan(start), is_last);
+    }
+    else
+    {
+        auto const& params = level_params[static_cast<size_t>(level)];
+        auto        finder = MatchFinder{input};
+        for (size_t position = start > window_size ? start - window_size : 0; position < start; ++position)
+            finder.insert(position);
+
+        auto   tokens      = std::vector<Token>{};
+        size_t block_start = start;
+        bool   wrote_final = false;
+        tokens.reserve(max_tokens_per_block);
+        size_t position = start;
+        while (position < input.size())
+        {
+            auto [length, distance] = finder.longest_match(position, params);
+            finder.insert(position);
+            if (length != 0 && params.lazy_matching && length < params.nice_length)
+            {
+                // If the next position has a longer match, it is better to emit a literal now and take that match instead
+                auto const next_length = finder.longest_match(position + 1, params).first;
+                if (next_length > length)
+                    length = 0;
+            }
+
+            if (length != 0)
+            {
+                tokens.push_back({static_cast<uint16_t>(length), static_cast<uint16_t>(distance)});
+                for (size_t i = 1; i < length; ++i)
+                    finder.insert(position + i);
+                position += length;
+            }
+            else
+            {
+                tokens.push_back({input[position], 0});
+                ++position;
+            }
+
+            if (tokens.size() >= max_tokens_per_block)
+            {
+                wrote_final = is_last && position == input.size();
+                writer.write_block(tokens, input.subspan(block_start, position - block_start), wrote_final);
+                tokens.clear();
+                block_start = position;
+            }
+        }
+        if (!tokens.empty() || (is_last && !wrote_final))
+            writer.write_block(tokens, input.subspan(block_start, position - block_start), is_last);
+    }
+
+    if (!is_last)
+        writer.write_sync_flush();
+    writer.finish();
+    return output;
+}
+
+auto zlib_compress_pieces(std::span<uint8_t const> data, int level, size_t threads_count) -> std::vector<std::vector<uint8_t>>
+{
+    auto const pieces_count = std::max((data.size() + piece_size - 1) / piece_size, size_t{1});
+    auto       pieces       = std::vector<std::vector<uint8_t>>(pieces_count);
+    auto       adlers       = std::vector<uint32_t>(pieces_count);
+    parallel_for(pieces_count, threads_count, [&](size_t i) {
+        auto const begin = i * piece_size;
+        auto const end   = std::min(begin + piece_size, data.size());
+        pieces[i]        = deflate(data.first(end), begin, level, i == pieces_count - 1);
+        adlers[i]        = adler32(data.subspan(begin, end - begin));
+    });
+
+    // zlib header. The second byte is chosen so that the header is a multiple of 31, and tells how hard we tried to compress.
+    auto const flags = level <= 1 ? uint8_t{0x01} : level <= 5 ? uint8_t{0x5E}
+                                                : level == 6   ? uint8_t{0x9C}
+                                                               : uint8_t{0xDA};
+    pieces.front().insert(pieces.front().begin(), {uint8_t{0x78}, flags});
+
+    uint32_t adler = adlers[0];
+    for (size_t i = 1; i < pieces_count; ++i)
+        adler = adler32_combine(adler, adlers[i], std::min(piece_size, data.size() - i * piece_size));
+    pieces.back().insert(pieces.back().end(), {static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16), static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler)});
+    return pieces;
+}
+
+auto zlib_compress(std::span<uint8_t const> data, int level) -> std::vector<uint8_t>
+{
+    auto pieces = zlib_compress_pieces(data, level, 1);
+    auto res    = std::move(pieces[0]);
+    for (size_t i = 1; i < pieces.size(); ++i)
+        res.insert(res.end(), pieces[i].begin(), pieces[i].end());
+    return res;
+}
+
+static constexpr uint32_t adler_base{65521};
+
+auto adler32(std::span<uint8_t const> data, uint32_t adler) -> uint32_t
+{
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (!data.empty())
+    {
+        // 5552 is the biggest number of bytes we can sum before b could overflow
+        auto const chunk = data.first(std::min(data.size(), size_t{5552}));
+        for (auto const byte : chunk)
+        {
+            a += byte;
+            b += a;
+        }
+        a %= adler_base;
+        b %= adler_base;
+        data = data.subspan(chunk.size());
+    }
+    return (b << 16) | a;
+}
+
+auto adler32_combine(uint32_t adler1, uint32_t adler2, size_t length2) -> uint32_t
+{
+    auto const remainder = static_cast<uint32_t>(length2 % adler_base);
+    uint32_t   sum1      = adler1 & 0xFFFF;
+    uint32_t   sum2      = (remainder * sum1) % adler_base;
+    sum1 += (adler2 & 0xFFFF) + adler_base - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + adler_base - remainder;
+    if (sum1 >= adler_base)
+        sum1 -= adler_base;
+    if (sum1 >= adler_base)
+        sum1 -= adler_base;
+    if (sum2 >= (adler_base << 1))
+        sum2 -= (adler_base << 1);
+    if (sum2 >= adler_base)
+        sum2 -= adler_base;
+    return sum1 | (sum2 << 16);
+}
+
+auto crc32(std::span<uint8_t const> data, uint32_t crc) -> uint32_t
+{
+    // "Slicing-by-8": tables[k][i] is the CRC of byte i followed by k zero bytes, which lets us process 8 bytes per iteration
+    static auto const tables = []() {
+        auto res = std::array<std::array<uint32_t, 256>, 8>{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            res[0][i] = c;
+        }
+        for (size_t k = 1; k < res.size(); ++k)
+        {
+            for (size_t i = 0; i < 256; ++i)
+                res[k][i] = res[0][res[k - 1][i] & 0xFF] ^ (res[k - 1][i] >> 8);
+        }
+        return res;
+    }();
+
+    crc        = ~crc;
+    size_t i   = 0;
+    auto   get = [&](size_t index) { return static_cast<uint32_t>(data[index]); };
+    for (; i + 8 <= data.size(); i += 8)
+    {
+        uint32_t const low  = crc ^ (get(i) | (get(i + 1) << 8) | (get(i + 2) << 16) | (get(i + 3) << 24));
+        uint32_t const high = get(i + 4) | (get(i + 5) << 8) | (get(i + 6) << 16) | (get(i + 7) << 24);
+        crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24]
+              ^ tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^ tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+    }
+    for (; i < data.size(); ++i)
+        crc = tables[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+} // namespace img::internal
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace img::internal {
+
+/// Compresses input[start, end) as a piece of a raw deflate stream (RFC 1951).
+/// The bytes in input[0, start) are the end of what has been compressed just before, and the matches are allowed to refer to them (only the last 32 KiB are used).
+/// If is_last is false the output ends with an empty stored block, so that it is byte-aligned and the next piece can be appended to it directly.
+/// @param level From 0 (no compression) to 9 (best compression).
+auto deflate(std::span<uint8_t const> input, size_t start, int level, bool is_last) -> std::vector<uint8_t>;
+
+/// Compresses data as a zlib stream (RFC 1950).
+/// The stream is split into independent pieces which are compressed in parallel (like pigz does). Concatenating all the pieces gives the full stream.
+/// @param threads_count 0 means one thread per hardware thread.
+auto zlib_compress_pieces(std::span<uint8_t const> data, int level, size_t threads_count) -> std::vector<std::vector<uint8_t>>;
+
+/// Compresses data as a single zlib stream (RFC 1950), on the calling thread.
+auto zlib_compress(std::span<uint8_t const> data, int level) -> std::vector<uint8_t>;
+
+auto adler32(std::span<uint8_t const> data, uint32_t adler = 1) -> uint32_t;
+/// Returns the adler32 of the concatenation of two buffers, given the adler32 of each of them and the length of the second one.
+auto adler32_combine(uint32_t adler1, uint32_t adler2, size_t length2) -> uint32_t;
+
+/// CRC-32 as used by PNG and gzip.
+auto crc32(std::span<uint8_t const> data, uint32_t crc = 0) -> uint32_t;
+
+} // namespace img::internal
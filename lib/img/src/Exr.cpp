@@ -0,0 +1,295 @@
+#include "Exr.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "Deflate.h"
+#include "Parallel.h"
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace img::internal {
+
+namespace {
+
+/// Where a rectangle of pixels (a scanline block or a tile) goes in the file.
+struct Chunk {
+    uint32_t x0, y0, x1, y1;          // The rectangle, in file coordinates (the first row is the top of the image)
+    uint32_t tile_x{0}, tile_y{0}; // Only used when the image is tiled
+};
+
+auto float_to_half(float value) -> uint16_t
+{
+    auto const bits     = std::bit_cast<uint32_t>(value);
+    auto const sign     = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    auto const abs_bits = bits & 0x7FFFFFFF;
+    if (abs_bits >= 0x7F800000) // Infinity or NaN
+        return static_cast<uint16_t>(sign | 0x7C00 | (abs_bits > 0x7F800000 ? 0x200 : 0));
+    if (abs_bits >= 0x477FF000) // Too big, rounds to infinity
+        return static_cast<uint16_t>(sign | 0x7C00);
+    if (abs_bits < 0x38800000) // Too small to be a normal half
+    {
+        if (abs_bits < 0x33000000) // Rounds to 0
+            return sign;
+        auto const shift    = 126 - (abs_bits >> 23);
+        auto const mantissa = (abs_bits & 0x7FFFFF) | 0x800000;
+        auto       half     = mantissa >> shift;
+        auto const rest     = mantissa & ((1u << shift) - 1);
+        auto const halfway  = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+    auto       half = (abs_bits - 0x38000000) >> 13; // Changes the exponent bias from 127 to 15
+    auto const rest = abs_bits & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        ++half;
+    return static_cast<uint16_t>(sign | half);
+}
+
+/// Writes a row of one channel. source points to the first value, and consecutive values are stride floats apart.
+void write_channel_row(float const* source, size_t stride, size_t count, ExrPixelType pixel_type, uint8_t*& out)
+{
+    if (pixel_type == ExrPixelType::Float)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto const bits = std::bit_cast<uint32_t>(source[i * stride]);
+            *out++          = static_cast<uint8_t>(bits);
+            *out++          = static_cast<uint8_t>(bits >> 8);
+            *out++          = static_cast<uint8_t>(bits >> 16);
+            *out++          = static_cast<uint8_t>(bits >> 24);
+        }
+        return;
+    }
+    size_t i = 0;
+#if defined(__F16C__)
+    for (; i + 8 <= count; i += 8)
+    {
+        auto values = std::array<float, 8>{};
+        for (size_t k = 0; k < 8; ++k)
+            values[k] = source[(i + k) * stride];
+        auto halves = std::array<uint16_t, 8>{};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(halves.data()), _mm256_cvtps_ph(_mm256_loadu_ps(values.data()), _MM_FROUND_TO_NEAREST_INT));
+        for (auto const half : halves)
+        {
+            *out++ = static_cast<uint8_t>(half);
+            *out++ = static_cast<uint8_t>(half >> 8);
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        auto const half = float_to_half(source[i * stride]);
+        *out++          = static_cast<uint8_t>(half);
+        *out++          = static_cast<uint8_t>(half >> 8);
+    }
+}
+
+/// Prepares the data like OpenEXR's ZIP compressor does: the bytes are split in two halves (even and odd indices), and each byte is replaced by its difference with the previous one.
+/// This makes the high and low bytes of the values end up in separate runs, which deflate compresses much better.
+auto zip_predictor(std::span<uint8_t const> raw) -> std::vector<uint8_t>
+{
+    auto       res  = std::vector<uint8_t>(raw.size());
+    auto const half = (raw.size() + 1) / 2;
+    for (size_t i = 0; i < raw.size(); ++i)
+        res[(i % 2 == 0) ? i / 2 : half + i / 2] = raw[i];
+    for (size_t i = res.size(); i-- > 1;)
+        res[i] = static_cast<uint8_t>(res[i] - res[i - 1] + 128);
+    return res;
+}
+
+auto compression_id(ExrCompression compression) -> uint8_t
+{
+    switch (compression)
+    {
+    case ExrCompression::None: return 0;
+    case ExrCompression::ZIPS: return 2;
+    case ExrCompression::ZIP: return 3;
+    }
+    return 0;
+}
+
+auto lines_per_block(ExrCompression compression) -> uint32_t
+{
+    return compression == ExrCompression::ZIP ? 16 : 1;
+}
+
+void append_u32(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+void append_u64(std::vector<uint8_t>& out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+void append_string(std::vector<uint8_t>& out, std::string_view str)
+{
+    out.insert(out.end(), str.begin(), str.end());
+    out.push_back(0);
+}
+
+void append_attribute(std::vector<uint8_t>& out, std::string_view name, std::string_view type, std::vector<uint8_t> const& value)
+{
+    append_string(out, name);
+    append_string(out, type);
+    append_u32(out, static_cast<uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+/// Names of the channels, sorted alphabetically as required by the file format, and the index of each of them in the interleaved input pixels.
+auto channels_layout(int channels_count) -> std::vector<std::pair<std::string_view, size_t>>
+{
+    switch (channels_count)
+    {
+    case 1: return {{"Y", 0}};
+    case 2: return {{"A", 1}, {"Y", 0}};
+    case 3: return {{"B", 2}, {"G", 1}, {"R", 0}};
+    case 4: return {{"A", 3}, {"B", 2}, {"G", 1}, {"R", 0}};
+    default: throw std::runtime_error{"[img::save_exr] Invalid channels count: " + std::to_string(channels_count) + ". It must be between 1 and 4."};
+    }
+}
+
+auto make_header(Size::DataType width, Size::DataType height, std::vector<std::pair<std::string_view, size_t>> const& channels, ExrOptions const& options) -> std::vector<uint8_t>
+{
+    auto header = std::vector<uint8_t>{0x76, 0x2F, 0x31, 0x01};
+    append_u32(header, options.tile_size != 0 ? 0x202 : 0x2); // Version 2, and the "single part tiled" flag
+
+    auto to_bytes = [](auto... values) {
+        auto res = std::vector<uint8_t>{};
+        (append_u32(res, std::bit_cast<uint32_t>(values)), ...);
+        return res;
+    };
+
+    auto channels_list = std::vector<uint8_t>{};
+    for (auto const& [name, _] : channels)
+    {
+        append_string(channels_list, name);
+        append_u32(channels_list, options.pixel_type == ExrPixelType::Half ? 1 : 2);
+        channels_list.insert(channels_list.end(), {0, 0, 0, 0}); // pLinear and reserved
+        append_u32(channels_list, 1);                            // xSampling
+        append_u32(channels_list, 1);                            // ySampling
+    }
+    channels_list.push_back(0);
+    auto const window = to_bytes(0, 0, static_cast<int32_t>(width) - 1, static_cast<int32_t>(height) - 1);
+
+    // Attributes are sorted alphabetically, like OpenEXR does
+    append_attribute(header, "channels", "chlist", channels_list);
+    append_attribute(header, "compression", "compression", {compression_id(options.compression)});
+    append_attribute(header, "dataWindow", "box2i", window);
+    append_attribute(header, "displayWindow", "box2i", window);
+    append_attribute(header, "lineOrder", "lineOrder", {0}); // INCREASING_Y
+    append_attribute(header, "pixelAspectRatio", "float", to_bytes(1.f));
+    append_attribute(header, "screenWindowCenter", "v2f", to_bytes(0.f, 0.f));
+    append_attribute(header, "screenWindowWidth", "float", to_bytes(1.f));
+    if (options.tile_size != 0)
+    {
+        auto tiles = to_bytes(options.tile_size, options.tile_size);
+        tiles.push_back(0); // ONE_LEVEL, ROUND_DOWN
+        append_attribute(header, "tiles", "tiledesc", tiles);
+    }
+    header.push_back(0); // End of the header
+    return header;
+}
+
+auto make_chunks(Size::DataType width, Size::DataType height, ExrOptions const& options) -> std::vector<Chunk>
+{
+    auto chunks = std::vector<Chunk>{};
+    if (options.tile_size != 0)
+    {
+        for (uint32_t y = 0; y < height; y += options.tile_size)
+        {
+            for (uint32_t x = 0; x < width; x += options.tile_size)
+            {
+                chunks.push_back({
+                    .x0     = x,
+                    .y0     = y,
+                    .x1     = std::min(x + options.tile_size, width),
+                    .y1     = std::min(y + options.tile_size, height),
+                    .tile_x = x / options.tile_size,
+                    .tile_y = y / options.tile_size,
+                });
+            }
+        }
+    }
+    else
+    {
+        auto const lines = lines_per_block(options.compression);
+        for (uint32_t y = 0; y < height; y += lines)
+            chunks.push_back({.x0 = 0, .y0 = y, .x1 = width, .y1 = std::min(y + lines, height)});
+    }
+    return chunks;
+}
+
+} // namespace
+
+auto encode_exr(Size::DataType width, Size::DataType height, float const* data, int channels_count, bool flip_vertically, ExrOptions const& options) -> std::vector<std::vector<uint8_t>>
+{
+    auto const channels = channels_layout(channels_count);
+    if (width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX)
+        throw std::runtime_error{"[img::save_exr] Invalid image size: " + std::to_string(width) + "x" + std::to_string(height) + "."};
+
+    auto const chunks      = make_chunks(width, height, options);
+    auto const value_size  = size_t{options.pixel_type == ExrPixelType::Half ? 2u : 4u};
+    auto const stride = static_cast<size_t>(channels_count);
+    auto       res         = std::vector<std::vector<uint8_t>>(chunks.size() + 1);
+
+    parallel_for(chunks.size(), options.threads_count, [&](size_t chunk_index) {
+        auto const& chunk = chunks[chunk_index];
+        auto const  chunk_width = static_cast<size_t>(chunk.x1 - chunk.x0);
+        auto        raw   = std::vector<uint8_t>(chunk_width * (chunk.y1 - chunk.y0) * channels.size() * value_size);
+        auto*       out   = raw.data();
+        for (uint32_t y = chunk.y0; y < chunk.y1; ++y)
+        {
+            auto const  source_y = flip_vertically ? height - 1 - y : y;
+            auto const* row      = data + (static_cast<size_t>(source_y) * width + chunk.x0) * stride;
+            for (auto const& [_, channel_index] : channels)
+                write_channel_row(row + channel_index, stride, chunk_width, options.pixel_type, out);
+        }
+
+        auto payload = std::vector<uint8_t>{};
+        if (options.compression != ExrCompression::None)
+            payload = zlib_compress(zip_predictor(raw), std::clamp(options.compression_level, 1, 9));
+        if (options.compression == ExrCompression::None || payload.size() >= raw.size())
+            payload = std::move(raw); // Readers know that the data is not compressed when its size is the uncompressed size
+
+        auto& buffer = res[chunk_index + 1];
+        buffer.reserve(payload.size() + 20);
+        if (options.tile_size != 0)
+        {
+            append_u32(buffer, chunk.tile_x);
+            append_u32(buffer, chunk.tile_y);
+            append_u32(buffer, 0); // Level x
+            append_u32(buffer, 0); // Level y
+        }
+        else
+        {
+            append_u32(buffer, chunk.y0);
+        }
+        append_u32(buffer, static_cast<uint32_t>(payload.size()));
+        buffer.insert(buffer.end(), payload.begin(), payload.end());
+    });
+
+    // Header, followed by the offset of each chunk in the file
+    auto& header = res.front();
+    header       = make_header(width, height, channels, options);
+    auto offset  = static_cast<uint64_t>(header.size() + 8 * chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        append_u64(header, offset);
+        offset += res[i + 1].size();
+    }
+    return res;
+}
+
+} // namespace img::internal
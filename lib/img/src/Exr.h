@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Save.h"
+
+namespace img::internal {
+
+/// Encodes an image as OpenEXR.
+/// Like encode_png(), the file is returned as several buffers that must be written one after the other: the header and offset table, and then one buffer per chunk (scanline block or tile).
+/// Throws a std::runtime_error if channels_count is not between 1 and 4.
+auto encode_exr(Size::DataType width, Size::DataType height, float const* data, int channels_count, bool flip_vertically, ExrOptions const& options) -> std::vector<std::vector<uint8_t>>;
+
+} // namespace img::internal
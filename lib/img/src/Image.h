@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <span>
 #include "Size.h"
@@ -15,7 +16,14 @@ public:
     /// It is your responsibility to make sure that size and channels_count properly match what is in data
     /// Alternatively you can use img::load() to create an Image
     Image(Size size, int channels_count, uint8_t* data)
-        : _size{size}, _channels_count{channels_count}, _data{data}
+        : Image{size, channels_count, data, [](uint8_t* ptr) { delete[] ptr; }}
+    {
+    }
+
+    /// NB: The Image takes ownership of the data pointer, and will call deleter(data) when it is destroyed
+    /// This allows the pixels to come from any allocator (malloc, an arena, a memory-mapped file, etc.)
+    Image(Size size, int channels_count, uint8_t* data, std::function<void(uint8_t*)> deleter)
+        : _size{size}, _channels_count{channels_count}, _data{data, std::move(deleter)}
     {
     }
 
@@ -44,9 +52,9 @@ public:
     size_t data_size() const { return width() * height() * static_cast<size_t>(channels_count()); }
 
 private:
-    Size                       _size;
-    int                        _channels_count;
-    std::unique_ptr<uint8_t[]> _data;
+    Size                                                      _size;
+    int                                                       _channels_count;
+    std::unique_ptr<uint8_t[], std::function<void(uint8_t*)>> _data;
 };
 
 } // namespace img
\ No newline at end of file
@@ -1,29 +1,103 @@
 #include "Load.h"
 #include <stb_image/stb_image.h>
+#include <atomic>
+#include <cassert>
+#include <climits>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include "MappedFile.h"
+#include "Operations.h"
+#include "Parallel.h"
 
 namespace img {
 
-Image load(std::filesystem::path file_path, std::optional<int> desired_channels_count, bool flip_vertically)
+/// @param source_name Used in the error messages
+static auto decode(std::span<std::byte const> data, LoadOptions const& options, std::string const& source_name) -> Image
 {
-    assert((!desired_channels_count.has_value() || *desired_channels_count != 0) && "If you don't want to enforce a channels count, don't set desired_channels_count to 0, but to std::nullopt");
-    assert(!desired_channels_count.has_value() || *desired_channels_count == 3 || *desired_channels_count == 4);
+    assert((!options.desired_channels_count.has_value() || *options.desired_channels_count != 0) && "If you don't want to enforce a channels count, don't set desired_channels_count to 0, but to std::nullopt");
+    assert(!options.desired_channels_count.has_value() || *options.desired_channels_count == 3 || *options.desired_channels_count == 4);
+
+    if (data.size() > static_cast<size_t>(INT_MAX))
+        throw std::runtime_error{"[img::load] Couldn't load image from " + source_name + ":\nThe file is too big"};
 
-    stbi_set_flip_vertically_on_load(flip_vertically ? 1 : 0);
+    // We never use stbi_set_flip_vertically_on_load() because it is a global setting: concurrent loads would flip each other's images.
+    // stb never flips, and we do it ourselves instead.
     int      w, h, actual_channels_count_in_file; // NOLINT
-    uint8_t* data = stbi_load(file_path.string().c_str(), &w, &h, &actual_channels_count_in_file, desired_channels_count.value_or(0));
-    if (!data)
-        throw std::runtime_error{"[img::load] Couldn't load image from \"" + file_path.string() + "\":\n" + stbi_failure_reason()};
+    uint8_t* pixels = stbi_load_from_memory(reinterpret_cast<stbi_uc const*>(data.data()), static_cast<int>(data.size()), &w, &h, &actual_channels_count_in_file, options.desired_channels_count.value_or(0));
+    if (!pixels)
+        throw std::runtime_error{"[img::load] Couldn't load image from " + source_name + ":\n" + stbi_failure_reason()}; // stbi_failure_reason() is thread-local
 
-    return Image{
+    auto image = Image{
         {
             static_cast<Size::DataType>(w),
             static_cast<Size::DataType>(h),
         },
-        desired_channels_count.value_or(actual_channels_count_in_file),
-        data,
+        options.desired_channels_count.value_or(actual_channels_count_in_file),
+        pixels,
+        [](uint8_t* ptr) { stbi_image_free(ptr); }, // stb allocates with malloc(), we must not use delete[]
+    };
+    if (options.flip_vertically)
+        flip_vertically(image, 1); // Loads are usually already done in parallel with each other
+    return image;
+}
+
+auto load(std::filesystem::path const& file_path, LoadOptions const& options) -> Image
+{
+    auto const file = MappedFile{file_path}; // Throws if the file doesn't exist
+    auto const source_name = std::string{"\""}.append(file_path.string()).append("\"");
+    return decode(file.bytes(), options, source_name);
+}
+
+auto load_from_memory(std::span<std::byte const> data, LoadOptions const& options) -> Image
+{
+    return decode(data, options, "memory");
+}
+
+Image load(std::filesystem::path file_path, std::optional<int> desired_channels_count, bool flip_vertically)
+{
+    return load(file_path, LoadOptions{.desired_channels_count = desired_channels_count, .flip_vertically = flip_vertically});
+}
+
+auto load_many(std::span<std::filesystem::path const> file_paths, LoadOptions const& options, size_t threads_count) -> LoadBatch
+{
+    // Shared with the loading threads, so that moving the LoadBatch doesn't invalidate what they are reading
+    struct Batch {
+        std::vector<std::filesystem::path> file_paths;
+        LoadOptions                        options;
+        std::vector<std::promise<Image>>   promises;
+        std::atomic<size_t>                next_index{0};
     };
+    auto batch        = std::make_shared<Batch>();
+    batch->file_paths = {file_paths.begin(), file_paths.end()};
+    batch->options    = options;
+    batch->promises.resize(file_paths.size());
+
+    auto res = LoadBatch{};
+    res.images.reserve(file_paths.size());
+    for (auto& promise : batch->promises)
+        res.images.push_back(promise.get_future());
+
+    auto const actual_threads_count = std::min(internal::resolve_threads_count(threads_count), file_paths.size());
+    res.threads.reserve(actual_threads_count);
+    for (size_t i = 0; i < actual_threads_count; ++i)
+    {
+        res.threads.emplace_back([batch](std::stop_token const& stop_token) {
+            for (size_t index = batch->next_index++; index < batch->file_paths.size() && !stop_token.stop_requested(); index = batch->next_index++)
+            {
+                try
+                {
+                    batch->promises[index].set_value(load(batch->file_paths[index], batch->options));
+                }
+                catch (...)
+                {
+                    batch->promises[index].set_exception(std::current_exception());
+                }
+            }
+        });
+    }
+    return res;
 }
 
-} // namespace img
\ No newline at end of file
+} // namespace img
@@ -1,10 +1,34 @@
 #pragma once
+#include <cstddef>
 #include <filesystem>
+#include <future>
 #include <optional>
+#include <span>
+#include <thread>
+#include <vector>
 #include "Image.h"
 
 namespace img {
 
+struct LoadOptions {
+    /// The number of channels that you want the image to have. For example if your file contains only RGB but you want RGBA, this will add a 4th component of 255 to each pixel. You can also set this to std::nullopt to use the same channels count as what is in the file.
+    std::optional<int> desired_channels_count{4};
+    /// By default we use the OpenGL convention: the first row will be the bottom of the image. You can set flip_vertically to false if you want the first row to be the top of the image
+    bool flip_vertically{true};
+};
+
+/// Loads an Image from a file
+/// Throws a std::runtime_error if the file doesn't exist or isn't a valid image file
+/// This is thread-safe: you can load several images at the same time from different threads, each with its own options.
+/// The file is memory-mapped and decoded directly from the mapping.
+/// @param file_path The path to the image: something like "icons/myImage.png"
+auto load(std::filesystem::path const& file_path, LoadOptions const& options) -> Image;
+
+/// Loads an Image from the content of an image file that is already in memory (e.g. inside an archive, or a MappedFile).
+/// Throws a std::runtime_error if data isn't a valid image file
+/// This is thread-safe, like load().
+auto load_from_memory(std::span<std::byte const> data, LoadOptions const& options = {}) -> Image;
+
 /// Loads an Image from a file
 /// Throws a std::runtime_error if the file doesn't exist or isn't a valid image file
 /// @param file_path The path to the image: something like "icons/myImage.png"
@@ -12,4 +36,16 @@ namespace img {
 /// @param flip_vertically By default we use the OpenGL convention: the first row will be the bottom of the image. You can set flip_vertically to false if you want the first row to be the top of the image
 Image load(std::filesystem::path file_path, std::optional<int> desired_channels_count = 4, bool flip_vertically = true);
 
+/// The result of load_many(). It owns the loading threads, so it must outlive the futures you are waiting on.
+struct LoadBatch {
+    /// images[i] gives the Image loaded from file_paths[i], or rethrows the std::runtime_error that img::load() would have thrown.
+    std::vector<std::future<Image>> images{};
+    /// Joined when the batch is destroyed. The files that haven't started loading by then are skipped, and their futures throw a std::future_error (broken_promise).
+    std::vector<std::jthread> threads{};
+};
+
+/// Starts loading all the files in parallel, and returns immediately.
+/// The images are decoded on threads_count threads (0 means one per hardware thread) that stop once all the files have been loaded.
+auto load_many(std::span<std::filesystem::path const> file_paths, LoadOptions const& options = {}, size_t threads_count = 0) -> LoadBatch;
+
 } // namespace img
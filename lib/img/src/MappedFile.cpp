@@ -0,0 +1,155 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace img {
+
+static auto error_message(std::filesystem::path const& file_path, std::string const& reason) -> std::string
+{
+    return "[img::MappedFile] Couldn't map file \"" + file_path.string() + "\":\n" + reason;
+}
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(std::filesystem::path const& file_path)
+{
+    HANDLE const file = CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error{error_message(file_path, "Unable to open file")};
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        throw std::runtime_error{error_message(file_path, "Unable to get the size of the file")};
+    }
+    _size = static_cast<size_t>(size.QuadPart);
+    if (_size == 0) // Empty files can't be mapped
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    _mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // The mapping keeps the file open
+    if (!_mapping)
+        throw std::runtime_error{error_message(file_path, "CreateFileMapping failed")};
+    _data = static_cast<std::byte const*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!_data)
+    {
+        CloseHandle(_mapping);
+        throw std::runtime_error{error_message(file_path, "MapViewOfFile failed")};
+    }
+}
+
+void MappedFile::unmap()
+{
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(_mapping);
+    _data    = nullptr;
+    _mapping = nullptr;
+    _size    = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : _data{std::exchange(other._data, nullptr)}
+    , _size{std::exchange(other._size, 0)}
+    , _mapping{std::exchange(other._mapping, nullptr)}
+{
+}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile&
+{
+    if (this != &other)
+    {
+        unmap();
+        _data    = std::exchange(other._data, nullptr);
+        _size    = std::exchange(other._size, 0);
+        _mapping = std::exchange(other._mapping, nullptr);
+    }
+    return *this;
+}
+
+#else
+
+MappedFile::MappedFile(std::filesystem::path const& file_path)
+{
+    int const file = open(file_path.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT(*vararg)
+    if (file == -1)
+        throw std::runtime_error{error_message(file_path, std::strerror(errno))};
+
+    struct stat status {};
+    if (fstat(file, &status) == -1)
+    {
+        auto const error = errno;
+        close(file);
+        throw std::runtime_error{error_message(file_path, std::strerror(error))};
+    }
+    _size = static_cast<size_t>(status.st_size);
+    if (_size == 0) // Empty files can't be mapped
+    {
+        close(file);
+        return;
+    }
+
+    void* const data  = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+    auto const  error = errno;
+    close(file); // The mapping keeps the file open
+    if (data == MAP_FAILED) // NOLINT(*cstyle-cast, *int-to-ptr)
+        throw std::runtime_error{error_message(file_path, std::strerror(error))};
+    _data = static_cast<std::byte const*>(data);
+}
+
+void MappedFile::unmap()
+{
+    if (_data)
+        munmap(const_cast<std::byte*>(_data), _size); // NOLINT(*const-cast)
+    _data = nullptr;
+    _size = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : _data{std::exchange(other._data, nullptr)}
+    , _size{std::exchange(other._size, 0)}
+{
+}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile&
+{
+    if (this != &other)
+    {
+        unmap();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+    }
+    return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+} // namespace img
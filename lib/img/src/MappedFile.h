@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace img {
+
+/// Maps a whole file in memory, read-only.
+/// The OS only reads the pages that are actually accessed, and we never copy the content of the file into a buffer of our own.
+/// You cannot copy a MappedFile. But you can move it.
+class MappedFile {
+public:
+    /// Throws a std::runtime_error if the file can't be opened or mapped.
+    explicit MappedFile(std::filesystem::path const& file_path);
+    ~MappedFile();
+    MappedFile(MappedFile const&)                    = delete;
+    auto operator=(MappedFile const&) -> MappedFile& = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+    /// The content of the file. Stays valid as long as the MappedFile is alive.
+    auto bytes() const -> std::span<std::byte const> { return {_data, _size}; }
+
+private:
+    void unmap();
+
+private:
+    std::byte const* _data{nullptr};
+    size_t           _size{0};
+#if defined(_WIN32)
+    void* _mapping{nullptr}; // HANDLE returned by CreateFileMapping
+#endif
+};
+
+} // namespace img
@@ -0,0 +1,570 @@
+#include "Operations.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <numbers>
+#include <stdexcept>
+#include "Parallel.h"
+
+#if defined(__AVX2__)
+#define IMG_USE_AVX2 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define IMG_USE_NEON 1
+#include <arm_neon.h>
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define IMG_USE_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+namespace img {
+
+namespace {
+
+/// Each job processes about that many bytes, so that small images don't pay for starting threads.
+constexpr size_t bytes_per_job{256 * 1024};
+
+auto rows_per_job(size_t row_size) -> size_t
+{
+    return std::max(bytes_per_job / std::max(row_size, size_t{1}), size_t{1});
+}
+
+auto row_size(Image const& image) -> size_t
+{
+    return static_cast<size_t>(image.width()) * static_cast<size_t>(image.channels_count());
+}
+
+/// Creates an image whose pixels are not initialized.
+auto make_image(Size size, int channels_count) -> Image
+{
+    auto const data_size = static_cast<size_t>(size.width()) * size.height() * static_cast<size_t>(channels_count);
+    return Image{size, channels_count, new uint8_t[data_size]}; // NOLINT(*owning-memory)
+}
+
+void for_each_row_range(Size::DataType height, size_t row_size, size_t threads_count, std::function<void(size_t begin, size_t end)> const& job)
+{
+    internal::parallel_for_ranges(height, rows_per_job(row_size), threads_count, job);
+}
+
+/// Divides by 255 with correct rounding. x must be <= 255 * 255.
+auto div255(uint32_t x) -> uint8_t
+{
+    x += 128;
+    return static_cast<uint8_t>((x + (x >> 8)) >> 8);
+}
+
+void rgb_to_rgba_row(uint8_t const* in, uint8_t* out, size_t width)
+{
+    size_t x = 0;
+#if IMG_USE_NEON
+    for (; x + 16 <= width; x += 16)
+    {
+        auto const rgb  = vld3q_u8(in + 3 * x);
+        auto       rgba = uint8x16x4_t{{rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255)}};
+        vst4q_u8(out + 4 * x, rgba);
+    }
+#elif IMG_USE_SSSE3
+    auto const shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    auto const alpha   = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    for (; x + 6 <= width; x += 4) // We load 16 bytes but only use 12, so we stop early enough not to read past the end of the row
+    {
+        auto const rgb = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 3 * x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * x), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        out[4 * x + 0] = in[3 * x + 0];
+        out[4 * x + 1] = in[3 * x + 1];
+        out[4 * x + 2] = in[3 * x + 2];
+        out[4 * x + 3] = 255;
+    }
+}
+
+void rgba_to_rgb_row(uint8_t const* in, uint8_t* out, size_t width)
+{
+    size_t x = 0;
+#if IMG_USE_NEON
+    for (; x + 16 <= width; x += 16)
+    {
+        auto const rgba = vld4q_u8(in + 4 * x);
+        auto       rgb  = uint8x16x3_t{{rgba.val[0], rgba.val[1], rgba.val[2]}};
+        vst3q_u8(out + 3 * x, rgb);
+    }
+#elif IMG_USE_SSSE3
+    auto const shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    for (; x + 4 <= width; x += 4)
+    {
+        auto const rgb = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 4 * x)), shuffle);
+        // Only store the 12 useful bytes, so that we don't write past the end of the row
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 3 * x), rgb);
+        auto const last_4_bytes = _mm_cvtsi128_si32(_mm_srli_si128(rgb, 8));
+        std::memcpy(out + 3 * x + 8, &last_4_bytes, 4);
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        out[3 * x + 0] = in[4 * x + 0];
+        out[3 * x + 1] = in[4 * x + 1];
+        out[3 * x + 2] = in[4 * x + 2];
+    }
+}
+
+void premultiply_rgba_row(uint8_t* pixels, size_t width)
+{
+    size_t x = 0;
+#if IMG_USE_AVX2
+    auto const zero          = _mm256_setzero_si256();
+    auto const alpha_shuffle = _mm256_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15, 6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+    auto const opaque        = _mm256_set1_epi16(255);
+    auto const rounding      = _mm256_set1_epi16(128);
+    auto const premultiply   = [&](__m256i channels) { // 4 pixels, with 16 bits per channel
+        auto alpha = _mm256_shuffle_epi8(channels, alpha_shuffle);
+        alpha      = _mm256_blend_epi16(alpha, opaque, 0x88); // Multiply alpha by 255 (and then divide it by 255) so that it doesn't change
+        auto const product = _mm256_add_epi16(_mm256_mullo_epi16(channels, alpha), rounding);
+        return _mm256_srli_epi16(_mm256_add_epi16(product, _mm256_srli_epi16(product, 8)), 8);
+    };
+    for (; x + 8 <= width; x += 8)
+    {
+        auto* const  address = reinterpret_cast<__m256i*>(pixels + 4 * x);
+        auto const   bytes   = _mm256_loadu_si256(address);
+        auto const   low     = premultiply(_mm256_unpacklo_epi8(bytes, zero));
+        auto const   high    = premultiply(_mm256_unpackhi_epi8(bytes, zero));
+        _mm256_storeu_si256(address, _mm256_packus_epi16(low, high));
+    }
+#elif IMG_USE_NEON
+    auto const premultiply = [](uint8x16_t channel, uint8x16_t alpha) {
+        auto const low  = vmull_u8(vget_low_u8(channel), vget_low_u8(alpha));
+        auto const high = vmull_u8(vget_high_u8(channel), vget_high_u8(alpha));
+        // Same rounding as div255()
+        return vcombine_u8(vrshrn_n_u16(vrsraq_n_u16(low, low, 8), 8), vrshrn_n_u16(vrsraq_n_u16(high, high, 8), 8));
+    };
+    for (; x + 16 <= width; x += 16)
+    {
+        auto rgba    = vld4q_u8(pixels + 4 * x);
+        rgba.val[0]  = premultiply(rgba.val[0], rgba.val[3]);
+        rgba.val[1]  = premultiply(rgba.val[1], rgba.val[3]);
+        rgba.val[2]  = premultiply(rgba.val[2], rgba.val[3]);
+        vst4q_u8(pixels + 4 * x, rgba);
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        auto* const pixel = pixels + 4 * x;
+        for (size_t c = 0; c < 3; ++c)
+            pixel[c] = div255(static_cast<uint32_t>(pixel[c]) * pixel[3]);
+    }
+}
+
+void check_has_alpha(Image const& image)
+{
+    assert((image.channels_count() == 2 || image.channels_count() == 4) && "The image must have an alpha channel");
+    (void)image;
+}
+
+auto srgb_to_linear_table() -> std::array<float, 256> const&
+{
+    static auto const table = []() {
+        auto res = std::array<float, 256>{};
+        for (size_t i = 0; i < res.size(); ++i)
+        {
+            auto const x = static_cast<float>(i) / 255.f;
+            res[i]       = x <= 0.04045f ? x / 12.92f : std::pow((x + 0.055f) / 1.055f, 2.4f);
+        }
+        return res;
+    }();
+    return table;
+}
+
+/// The linear -> sRGB table is indexed by the top bits of the float, which gives a good precision for dark values (where the sRGB curve is steep) without needing a huge table.
+constexpr uint32_t linear_to_srgb_min_bits{0x39000000}; // 2^-13. Smaller values all become 0.
+constexpr uint32_t linear_to_srgb_max_bits{0x3F800000}; // 1
+constexpr uint32_t linear_to_srgb_shift{12};            // Keeps 11 bits of mantissa
+
+auto linear_to_srgb_table() -> std::vector<uint8_t> const&
+{
+    static auto const table = []() {
+        auto res = std::vector<uint8_t>((linear_to_srgb_max_bits - linear_to_srgb_min_bits) >> linear_to_srgb_shift);
+        for (size_t i = 0; i < res.size(); ++i)
+        {
+            auto const bits = linear_to_srgb_min_bits + (static_cast<uint32_t>(i) << linear_to_srgb_shift) + (1u << (linear_to_srgb_shift - 1)); // Middle of the range covered by this entry
+            auto const x    = std::bit_cast<float>(bits);
+            auto const srgb = x <= 0.0031308f ? x * 12.92f : 1.055f * std::pow(x, 1.f / 2.4f) - 0.055f;
+            res[i]          = static_cast<uint8_t>(std::lround(srgb * 255.f));
+        }
+        return res;
+    }();
+    return table;
+}
+
+auto linear_to_srgb_value(float x, std::vector<uint8_t> const& table) -> uint8_t
+{
+    auto const bits = std::bit_cast<uint32_t>(x);
+    if (!(x > std::bit_cast<float>(linear_to_srgb_min_bits))) // Also catches NaNs
+        return 0;
+    if (bits >= linear_to_srgb_max_bits)
+        return 255;
+    return table[(bits - linear_to_srgb_min_bits) >> linear_to_srgb_shift];
+}
+
+auto float_to_byte(float x) -> uint8_t
+{
+    return static_cast<uint8_t>(std::clamp(x, 0.f, 1.f) * 255.f + 0.5f);
+}
+
+/* ---------------------------------- Resize ---------------------------------- */
+
+auto filter_support(ResizeFilter filter) -> float
+{
+    switch (filter)
+    {
+    case ResizeFilter::Box: return 0.5f;
+    case ResizeFilter::Triangle: return 1.f;
+    case ResizeFilter::CatmullRom: return 2.f;
+    case ResizeFilter::Mitchell: return 2.f;
+    case ResizeFilter::Lanczos3: return 3.f;
+    }
+    return 1.f;
+}
+
+/// Mitchell-Netravali family of cubic filters
+auto cubic(float x, float b, float c) -> float
+{
+    x = std::abs(x);
+    if (x < 1.f)
+        return ((12.f - 9.f * b - 6.f * c) * x * x * x + (-18.f + 12.f * b + 6.f * c) * x * x + (6.f - 2.f * b)) / 6.f;
+    if (x < 2.f)
+        return ((-b - 6.f * c) * x * x * x + (6.f * b + 30.f * c) * x * x + (-12.f * b - 48.f * c) * x + (8.f * b + 24.f * c)) / 6.f;
+    return 0.f;
+}
+
+auto sinc(float x) -> float
+{
+    if (std::abs(x) < 1e-5f)
+        return 1.f;
+    x *= std::numbers::pi_v<float>;
+    return std::sin(x) / x;
+}
+
+auto filter_weight(ResizeFilter filter, float x) -> float
+{
+    switch (filter)
+    {
+    case ResizeFilter::Box: return x >= -0.5f && x < 0.5f ? 1.f : 0.f;
+    case ResizeFilter::Triangle: return std::max(1.f - std::abs(x), 0.f);
+    case ResizeFilter::CatmullRom: return cubic(x, 0.f, 0.5f);
+    case ResizeFilter::Mitchell: return cubic(x, 1.f / 3.f, 1.f / 3.f);
+    case ResizeFilter::Lanczos3: return std::abs(x) < 3.f ? sinc(x) * sinc(x / 3.f) : 0.f;
+    }
+    return 0.f;
+}
+
+/// For each output pixel along one axis, the input pixels that contribute to it and their weights.
+struct Contributions {
+    std::vector<size_t> first;      // Index of the first contributing input pixel
+    std::vector<size_t> taps_count; // Number of contributing input pixels
+    std::vector<float>  weights;    // max_taps_count weights per output pixel
+    size_t              max_taps_count{};
+};
+
+auto compute_contributions(size_t input_size, size_t output_size, ResizeFilter filter) -> Contributions
+{
+    assert(input_size >= 1 && output_size >= 1 && "Guaranteed by img::Size. We divide by output_size, and clamp the taps to [0, input_size - 1].");
+    auto const input_per_output = static_cast<float>(input_size) / static_cast<float>(output_size);
+    auto const filter_scale     = std::max(input_per_output, 1.f); // When downscaling we widen the filter so that every input pixel is taken into account
+    auto const support          = filter_support(filter) * filter_scale;
+    auto const max_taps_count   = static_cast<size_t>(std::ceil(2.f * support)) + 2;
+
+    auto res = Contributions{
+        .first          = std::vector<size_t>(output_size),
+        .taps_count     = std::vector<size_t>(output_size),
+        .weights        = std::vector<float>(output_size * max_taps_count, 0.f),
+        .max_taps_count = 0,
+    };
+    auto weights_per_input = std::vector<float>{};
+    for (size_t i = 0; i < output_size; ++i)
+    {
+        auto const center = (static_cast<float>(i) + 0.5f) * input_per_output; // In input pixels, where the center of pixel j is at j + 0.5
+        auto const begin  = static_cast<int64_t>(std::floor(center - support));
+        auto const end    = static_cast<int64_t>(std::ceil(center + support));
+        auto const last   = static_cast<int64_t>(input_size) - 1;
+        auto const first  = std::clamp(begin, int64_t{0}, last);
+
+        // Pixels outside of the image are replaced by the closest pixel on the edge
+        weights_per_input.assign(static_cast<size_t>(std::clamp(end, int64_t{0}, last) - first + 1), 0.f);
+        float total = 0.f;
+        for (auto j = begin; j <= end; ++j)
+        {
+            auto const weight = filter_weight(filter, (static_cast<float>(j) + 0.5f - center) / filter_scale);
+            weights_per_input[static_cast<size_t>(std::clamp(j, int64_t{0}, last) - first)] += weight;
+            total += weight;
+        }
+        if (total == 0.f) // Can't happen with the filters we have, but let's not divide by 0
+        {
+            weights_per_input.assign(1, 1.f);
+            total = 1.f;
+        }
+
+        // Skip the zero weights at both ends
+        size_t taps_begin = 0;
+        size_t taps_end   = weights_per_input.size();
+        while (taps_begin + 1 < taps_end && weights_per_input[taps_begin] == 0.f)
+            ++taps_begin;
+        while (taps_end - 1 > taps_begin && weights_per_input[taps_end - 1] == 0.f)
+            --taps_end;
+        assert(taps_end - taps_begin <= max_taps_count);
+
+        res.first[i]      = static_cast<size_t>(first) + taps_begin;
+        res.taps_count[i] = taps_end - taps_begin;
+        for (size_t k = taps_begin; k < taps_end; ++k)
+            res.weights[i * max_taps_count + k - taps_begin] = weights_per_input[k] / total;
+        res.max_taps_count = std::max(res.max_taps_count, taps_end - taps_begin);
+    }
+
+    // Make the storage tighter now that we know how many taps we really need
+    if (res.max_taps_count != max_taps_count)
+    {
+        for (size_t i = 0; i < output_size; ++i)
+            std::copy_n(res.weights.begin() + static_cast<std::ptrdiff_t>(i * max_taps_count), res.max_taps_count, res.weights.begin() + static_cast<std::ptrdiff_t>(i * res.max_taps_count));
+        res.weights.resize(output_size * res.max_taps_count);
+    }
+    return res;
+}
+
+/// accumulator[i] += weight * row[i]
+void accumulate_row(float* accumulator, float const* row, float weight, size_t size)
+{
+    size_t i = 0;
+#if IMG_USE_AVX2
+    auto const w = _mm256_set1_ps(weight);
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(accumulator + i, _mm256_add_ps(_mm256_loadu_ps(accumulator + i), _mm256_mul_ps(w, _mm256_loadu_ps(row + i))));
+#elif IMG_USE_NEON
+    for (; i + 4 <= size; i += 4)
+        vst1q_f32(accumulator + i, vmlaq_n_f32(vld1q_f32(accumulator + i), vld1q_f32(row + i), weight));
+#endif
+    for (; i < size; ++i)
+        accumulator[i] += weight * row[i];
+}
+
+/// Rounds and clamps values in [0, 255] to bytes
+void store_row(float const* values, uint8_t* out, size_t size)
+{
+    size_t i = 0;
+#if IMG_USE_AVX2
+    auto const zero = _mm256_setzero_ps();
+    auto const max  = _mm256_set1_ps(255.f);
+    for (; i + 8 <= size; i += 8)
+    {
+        auto const integers = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(values + i), zero), max));
+        auto const shorts   = _mm256_packus_epi32(integers, integers);      // Packs inside each 128-bit lane
+        auto const bytes    = _mm256_packus_epi16(shorts, shorts);          // The 4 bytes of each lane are now at the beginning of the lane
+        auto const joined   = _mm_unpacklo_epi32(_mm256_castsi256_si128(bytes), _mm256_extracti128_si256(bytes, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), joined);
+    }
+#elif IMG_USE_NEON
+    auto const max = vdupq_n_f32(255.f);
+    for (; i + 8 <= size; i += 8)
+    {
+        auto const low  = vcvtnq_u32_f32(vminq_f32(vmaxq_f32(vld1q_f32(values + i), vdupq_n_f32(0.f)), max));
+        auto const high = vcvtnq_u32_f32(vminq_f32(vmaxq_f32(vld1q_f32(values + i + 4), vdupq_n_f32(0.f)), max));
+        vst1_u8(out + i, vqmovn_u16(vcombine_u16(vqmovn_u32(low), vqmovn_u32(high))));
+    }
+#endif
+    for (; i < size; ++i)
+        out[i] = static_cast<uint8_t>(std::nearbyint(std::clamp(values[i], 0.f, 255.f))); // Rounds half to even, like the SIMD versions
+}
+
+} // namespace
+
+void flip_vertically(Image& image, size_t threads_count)
+{
+    auto const size   = row_size(image);
+    auto const height = static_cast<size_t>(image.height());
+    auto* const data  = image.data();
+    // Each job swaps a range of rows from the top half with the corresponding rows of the bottom half
+    internal::parallel_for_ranges(height / 2, rows_per_job(2 * size), threads_count, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y)
+            std::swap_ranges(data + y * size, data + (y + 1) * size, data + (height - 1 - y) * size);
+    });
+}
+
+auto flipped_vertically(Image const& image, size_t threads_count) -> Image
+{
+    auto       res    = make_image(image.size(), image.channels_count());
+    auto const size   = row_size(image);
+    auto const height = static_cast<size_t>(image.height());
+    for_each_row_range(image.height(), size, threads_count, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y)
+            std::copy_n(image.data() + (height - 1 - y) * size, size, res.data() + y * size);
+    });
+    return res;
+}
+
+auto convert_channels(Image const& image, int desired_channels_count, size_t threads_count) -> Image
+{
+    auto const channels_count = image.channels_count();
+    assert((channels_count == desired_channels_count || (channels_count == 3 && desired_channels_count == 4) || (channels_count == 4 && desired_channels_count == 3)) && "Only the conversions between RGB and RGBA are supported");
+
+    auto       res    = make_image(image.size(), desired_channels_count);
+    auto const width  = static_cast<size_t>(image.width());
+    auto const input  = row_size(image);
+    auto const output = row_size(res);
+    for_each_row_range(image.height(), std::max(input, output), threads_count, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y)
+        {
+            auto const* in  = image.data() + y * input;
+            auto* const out = res.data() + y * output;
+            if (channels_count == desired_channels_count)
+                std::copy_n(in, input, out);
+            else if (desired_channels_count == 4)
+                rgb_to_rgba_row(in, out, width);
+            else
+                rgba_to_rgb_row(in, out, width);
+        }
+    });
+    return res;
+}
+
+void premultiply_alpha(Image& image, size_t threads_count)
+{
+    check_has_alpha(image);
+    auto const width = static_cast<size_t>(image.width());
+    auto const size  = row_size(image);
+    for_each_row_range(image.height(), size, threads_count, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y)
+        {
+            auto* const row = image.data() + y * size;
+            if (image.channels_count() == 4)
+            {
+                premultiply_rgba_row(row, width);
+                continue;
+            }
+            for (size_t x = 0; x < width; ++x)
+                row[2 * x] = div255(static_cast<uint32_t>(row[2 * x]) * row[2 * x + 1]);
+        }
+    });
+}
+
+void unpremultiply_alpha(Image& image, size_t threads_count)
+{
+    check_has_alpha(image);
+    // 16.16 fixed point reciprocals, so that we don't need a division per channel
+    static auto const reciprocals = []() {
+        auto res = std::array<uint32_t, 256>{};
+        for (uint32_t alpha = 1; alpha < 256; ++alpha)
+            res[alpha] = (255u * 65536u + alpha / 2) / alpha;
+        return res;
+    }();
+
+    auto const width          = static_cast<size_t>(image.width());
+    auto const channels_count = static_cast<size_t>(image.channels_count());
+    auto const size           = row_size(image);
+    for_each_row_range(image.height(), size, threads_count, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y)
+        {
+            auto* const row = image.data() + y * size;
+            for (size_t x = 0; x < width; ++x)
+            {
+                auto* const pixel      = row + x * channels_count;
+                auto const  reciprocal = reciprocals[pixel[channels_count - 1]];
+                for (size_t c = 0; c < channels_count - 1; ++c)
+                    pixel[c] = static_cast<uint8_t>(std::min((pixel[c] * reciprocal + 32768u) >> 16, 255u));
+            }
+        }
+    });
+}
+
+auto srgb_to_linear(Image const& image, size_t threads_count) -> std::vector<float>
+{
+    auto const& table          = srgb_to_linear_table();
+    auto const  channels_count = static_cast<size_t>(image.channels_count());
+    auto const  has_alpha      = channels_count == 2 || channels_count == 4;
+    auto const  size           = row_size(image);
+    auto        res            = std::vector<float>(image.data_size());
+    for_each_row_range(image.height(), size * sizeof(float), threads_count, [&](size_t begin, size_t end) {
+        for (size_t i = begin * size; i < end * size; ++i)
+        {
+            auto const is_alpha = has_alpha && i % channels_count == channels_count - 1;
+            res[i]              = is_alpha ? static_cast<float>(image.data()[i]) / 255.f : table[image.data()[i]];
+        }
+    });
+    return res;
+}
+
+auto linear_to_srgb(std::span<float const> data, Size size, int channels_count, size_t threads_count) -> Image
+{
+    auto res = make_image(size, channels_count);
+    assert(data.size() == res.data_size());
+    auto const& table     = linear_to_srgb_table();
+    auto const  channels  = static_cast<size_t>(channels_count);
+    auto const  has_alpha = channels == 2 || channels == 4;
+    auto const  row       = row_size(res);
+    for_each_row_range(size.height(), row * sizeof(float), threads_count, [&](size_t begin, size_t end) {
+        for (size_t i = begin * row; i < end * row; ++i)
+        {
+            auto const is_alpha = has_alpha && i % channels == channels - 1;
+            res.data()[i]       = is_alpha ? float_to_byte(data[i]) : linear_to_srgb_value(data[i], table);
+        }
+    });
+    return res;
+}
+
+auto resize(Image const& image, Size new_size, ResizeFilter filter, size_t threads_count) -> Image
+{
+    assert(image.channels_count() >= 1 && image.channels_count() <= 4);
+    if (image.data() == nullptr)
+        throw std::runtime_error{"[img::resize] Can't resize an image that has no data (e.g. because it has been moved from)."};
+    auto const channels_count = static_cast<size_t>(image.channels_count());
+    auto const input_width    = static_cast<size_t>(image.width());
+    auto const output_width   = static_cast<size_t>(new_size.width());
+    auto const horizontal     = compute_contributions(input_width, output_width, filter);
+    auto const vertical       = compute_contributions(image.height(), new_size.height(), filter);
+
+    // Horizontal pass: each input row is resized to the new width, into floats
+    auto const temporary_row_size = output_width * channels_count;
+    auto       temporary          = std::vector<float>(temporary_row_size * image.height());
+    for_each_row_range(image.height(), temporary_row_size * sizeof(float), threads_count, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y)
+        {
+            auto const* in  = image.data() + y * input_width * channels_count;
+            auto* const out = temporary.data() + y * temporary_row_size;
+            for (size_t x = 0; x < output_width; ++x)
+            {
+                auto const* weights = horizontal.weights.data() + x * horizontal.max_taps_count;
+                auto const* pixels  = in + horizontal.first[x] * channels_count;
+                auto        sum     = std::array<float, 4>{};
+                for (size_t k = 0; k < horizontal.taps_count[x]; ++k)
+                {
+                    for (size_t c = 0; c < channels_count; ++c)
+                        sum[c] += weights[k] * static_cast<float>(pixels[k * channels_count + c]);
+                }
+                std::copy_n(sum.begin(), channels_count, out + x * channels_count);
+            }
+        }
+    });
+
+    // Vertical pass: each output row is a weighted sum of rows of the temporary image
+    auto res = make_image(new_size, image.channels_count());
+    for_each_row_range(new_size.height(), temporary_row_size * sizeof(float), threads_count, [&](size_t begin, size_t end) {
+        auto accumulator = std::vector<float>(temporary_row_size);
+        for (size_t y = begin; y < end; ++y)
+        {
+            std::fill(accumulator.begin(), accumulator.end(), 0.f);
+            for (size_t k = 0; k < vertical.taps_count[y]; ++k)
+            {
+                auto const* row = temporary.data() + (vertical.first[y] + k) * temporary_row_size;
+                accumulate_row(accumulator.data(), row, vertical.weights[y * vertical.max_taps_count + k], temporary_row_size);
+            }
+            store_row(accumulator.data(), res.data() + y * temporary_row_size, temporary_row_size);
+        }
+    });
+    return res;
+}
+
+} // namespace img
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "Image.h"
+
+namespace img {
+
+/// All the operations below are parallelized over the rows of the image.
+/// @param threads_count The maximum number of threads used by the operation. 0 means one per hardware thread. Small images are always processed on the calling thread.
+
+/// Flips the image upside down, in place.
+void flip_vertically(Image& image, size_t threads_count = 0);
+
+/// Returns a copy of the image, flipped upside down.
+auto flipped_vertically(Image const& image, size_t threads_count = 0) -> Image;
+
+/// Returns a copy of the image with desired_channels_count channels.
+/// Only the conversions between RGB and RGBA are supported: going from 3 to 4 channels adds an opaque alpha, going from 4 to 3 channels drops the alpha.
+/// Converting to the same number of channels simply copies the image.
+auto convert_channels(Image const& image, int desired_channels_count, size_t threads_count = 0) -> Image;
+
+/// Multiplies the color channels of each pixel by its alpha, in place.
+/// The image must have 2 (grey + alpha) or 4 (RGBA) channels.
+void premultiply_alpha(Image& image, size_t threads_count = 0);
+
+/// Divides the color channels of each pixel by its alpha, in place. This is the inverse of premultiply_alpha() (up to the precision lost when premultiplying).
+/// Pixels whose alpha is 0 become black.
+/// The image must have 2 (grey + alpha) or 4 (RGBA) channels.
+void unpremultiply_alpha(Image& image, size_t threads_count = 0);
+
+/// Converts the colors of an sRGB image to linear values between 0 and 1.
+/// If the image has an alpha channel (i.e. it has 2 or 4 channels) the alpha is not converted, it is only remapped to [0, 1].
+/// The returned floats are laid out like the channels of the image.
+auto srgb_to_linear(Image const& image, size_t threads_count = 0) -> std::vector<float>;
+
+/// Converts linear colors to an sRGB image. This is the inverse of srgb_to_linear(). Values outside of [0, 1] are clamped.
+/// @param data The channels of each pixel, laid out like in an Image. Must contain size.width() * size.height() * channels_count floats.
+auto linear_to_srgb(std::span<float const> data, Size size, int channels_count, size_t threads_count = 0) -> Image;
+
+enum class ResizeFilter {
+    Box,        // Nearest neighbour when upscaling, average of the covered pixels when downscaling
+    Triangle,   // Bilinear
+    CatmullRom, // Sharp cubic
+    Mitchell,   // Cubic with a good balance between blurring and ringing
+    Lanczos3,   // Sharpest, but can produce some ringing around hard edges
+};
+
+/// Returns a copy of the image resampled to new_size.
+/// The filter is widened when downscaling, so that all the input pixels contribute to the result (no aliasing).
+/// NB: if the image has an alpha channel you will usually want to premultiply it before resizing, and unpremultiply it after, otherwise the color of transparent pixels bleeds into their neighbours.
+/// Throws if the image has no data (e.g. because it has been moved from). Sizes can't be 0, img::Size clamps them to 1.
+auto resize(Image const& image, Size new_size, ResizeFilter filter = ResizeFilter::Mitchell, size_t threads_count = 0) -> Image;
+
+} // namespace img
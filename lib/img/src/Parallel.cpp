@@ -0,0 +1,66 @@
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace img::internal {
+
+auto resolve_threads_count(size_t threads_count) -> size_t
+{
+    if (threads_count != 0)
+        return threads_count;
+    return std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t{1});
+}
+
+void parallel_for(size_t count, size_t threads_count, std::function<void(size_t)> const& job)
+{
+    auto const actual_threads_count = std::min(resolve_threads_count(threads_count), count);
+    if (actual_threads_count <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            job(i);
+        return;
+    }
+
+    auto next_index      = std::atomic<size_t>{0};
+    auto exception_mutex = std::mutex{};
+    auto first_exception = std::exception_ptr{};
+    auto work            = [&]() {
+        for (size_t i = next_index++; i < count; i = next_index++)
+        {
+            try
+            {
+                job(i);
+            }
+            catch (...)
+            {
+                auto lock = std::unique_lock{exception_mutex};
+                if (!first_exception)
+                    first_exception = std::current_exception();
+            }
+        }
+    };
+
+    {
+        auto threads = std::vector<std::jthread>{};
+        for (size_t i = 1; i < actual_threads_count; ++i)
+            threads.emplace_back(work);
+        work();
+    } // Joins the threads
+
+    if (first_exception)
+        std::rethrow_exception(first_exception);
+}
+
+void parallel_for_ranges(size_t count, size_t grain_size, size_t threads_count, std::function<void(size_t begin, size_t end)> const& job)
+{
+    grain_size = std::max(grain_size, size_t{1});
+    parallel_for((count + grain_size - 1) / grain_size, threads_count, [&](size_t i) {
+        job(i * grain_size, std::min((i + 1) * grain_size, count));
+    });
+}
+
+} // namespace img::internal
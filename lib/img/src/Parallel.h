@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+namespace img::internal {
+
+/// Returns threads_count, or the number of hardware threads if threads_count is 0.
+auto resolve_threads_count(size_t threads_count) -> size_t;
+
+/// Calls job(i) for each i in [0, count), spread over up to threads_count threads (0 means one per hardware thread).
+/// The calling thread takes part in the work. If some jobs throw, the first exception is rethrown once all the threads have finished.
+void parallel_for(size_t count, size_t threads_count, std::function<void(size_t)> const& job);
+
+/// Splits [0, count) into ranges of grain_size elements (the last one can be smaller) and calls job(begin, end) for each of them, like parallel_for() does.
+/// Typically used to process the rows of an image: when the image is small there is only one range and no thread is started.
+void parallel_for_ranges(size_t count, size_t grain_size, size_t threads_count, std::function<void(size_t begin, size_t end)> const& job);
+
+} // namespace img::internal
@@ -0,0 +1,229 @@
+#include "Png.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include "Deflate.h"
+#include "Parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMG_PNG_USE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define IMG_PNG_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace img::internal {
+
+namespace {
+
+constexpr size_t rows_per_job{32};
+
+enum class Filter : uint8_t {
+    None    = 0,
+    Sub     = 1,
+    Up      = 2,
+    Average = 3,
+    Paeth   = 4,
+};
+
+constexpr std::array all_filters{Filter::None, Filter::Sub, Filter::Up, Filter::Average, Filter::Paeth};
+
+auto paeth_predictor(int a, int b, int c) -> int
+{
+    int const p  = a + b - c;
+    int const pa = std::abs(p - a);
+    int const pb = std::abs(p - b);
+    int const pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    if (pb <= pc)
+        return b;
+    return c;
+}
+
+/// Filters a row. previous is the (unfiltered) row above it, filled with zeros for the first row.
+/// There is no dependency between the output bytes so the compiler is free to vectorize these loops.
+void apply_filter(Filter filter, std::span<uint8_t const> row, std::span<uint8_t const> previous, size_t bytes_per_pixel, std::span<uint8_t> out)
+{
+    auto const size = row.size();
+    switch (filter)
+    {
+    case Filter::None:
+        std::copy(row.begin(), row.end(), out.begin());
+        break;
+    case Filter::Sub:
+        std::copy_n(row.begin(), bytes_per_pixel, out.begin());
+        for (size_t i = bytes_per_pixel; i < size; ++i)
+            out[i] = static_cast<uint8_t>(row[i] - row[i - bytes_per_pixel]);
+        break;
+    case Filter::Up:
+        for (size_t i = 0; i < size; ++i)
+            out[i] = static_cast<uint8_t>(row[i] - previous[i]);
+        break;
+    case Filter::Average:
+        for (size_t i = 0; i < bytes_per_pixel; ++i)
+            out[i] = static_cast<uint8_t>(row[i] - (previous[i] >> 1));
+        for (size_t i = bytes_per_pixel; i < size; ++i)
+            out[i] = static_cast<uint8_t>(row[i] - ((row[i - bytes_per_pixel] + previous[i]) >> 1));
+        break;
+    case Filter::Paeth:
+        for (size_t i = 0; i < bytes_per_pixel; ++i)
+            out[i] = static_cast<uint8_t>(row[i] - previous[i]); // Paeth(0, b, 0) == b
+        for (size_t i = bytes_per_pixel; i < size; ++i)
+            out[i] = static_cast<uint8_t>(row[i] - paeth_predictor(row[i - bytes_per_pixel], previous[i], previous[i - bytes_per_pixel]));
+        break;
+    }
+}
+
+/// Sum of the absolute values of the bytes interpreted as signed integers. This is the heuristic recommended by the PNG specification to choose a filter: the smaller the better.
+auto filter_score(std::span<uint8_t const> filtered) -> uint64_t
+{
+    uint64_t score = 0;
+    size_t   i     = 0;
+#if IMG_PNG_USE_SSE2
+    auto const zero = _mm_setzero_si128();
+    auto       sums = _mm_setzero_si128();
+    for (; i + 16 <= filtered.size(); i += 16)
+    {
+        auto const bytes     = _mm_loadu_si128(reinterpret_cast<__m128i const*>(filtered.data() + i));
+        auto const abs_bytes = _mm_min_epu8(bytes, _mm_sub_epi8(zero, bytes)); // |x| == min(x, -x) when the bytes are read back as unsigned
+        sums                 = _mm_add_epi64(sums, _mm_sad_epu8(abs_bytes, zero));
+    }
+    alignas(16) auto lanes = std::array<uint64_t, 2>{};
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes.data()), sums);
+    score = lanes[0] + lanes[1];
+#elif IMG_PNG_USE_NEON
+    auto sums = vdupq_n_u32(0);
+    for (; i + 16 <= filtered.size(); i += 16)
+    {
+        auto const abs_bytes = vreinterpretq_u8_s8(vabsq_s8(vreinterpretq_s8_u8(vld1q_u8(filtered.data() + i))));
+        sums                 = vpadalq_u16(sums, vpaddlq_u8(abs_bytes));
+    }
+    score = vaddvq_u32(sums);
+#endif
+    for (; i < filtered.size(); ++i)
+    {
+        auto const byte = filtered[i];
+        score += byte < 128 ? byte : 256u - byte;
+    }
+    return score;
+}
+
+void write_u32_big_endian(uint32_t value, uint8_t* out)
+{
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+auto make_chunk(char const (&type)[5], std::span<uint8_t const> data) -> std::vector<uint8_t> // NOLINT(*avoid-c-arrays)
+{
+    auto chunk = std::vector<uint8_t>(12 + data.size());
+    write_u32_big_endian(static_cast<uint32_t>(data.size()), chunk.data());
+    std::copy_n(type, 4, chunk.begin() + 4);
+    std::copy(data.begin(), data.end(), chunk.begin() + 8);
+    auto const crc = crc32(std::span{chunk}.subspan(4, 4 + data.size()));
+    write_u32_big_endian(crc, chunk.data() + 8 + data.size());
+    return chunk;
+}
+
+auto color_type(int channels_count) -> uint8_t
+{
+    switch (channels_count)
+    {
+    case 1: return 0; // Greyscale
+    case 2: return 4; // Greyscale + alpha
+    case 3: return 2; // RGB
+    case 4: return 6; // RGBA
+    default: throw std::runtime_error{"[img::save_png] Invalid channels count: " + std::to_string(channels_count) + ". It must be between 1 and 4."};
+    }
+}
+
+/// Returns the filtered image data, as expected by the IDAT chunks: each row starts with the type of filter that was applied to it.
+auto filter_rows(Size::DataType width, Size::DataType height, uint8_t const* data, size_t bytes_per_pixel, bool flip_vertically, PngOptions const& options) -> std::vector<uint8_t>
+{
+    auto const row_size          = static_cast<size_t>(width) * bytes_per_pixel;
+    auto const filtered_row_size = row_size + 1;
+    auto       filtered          = std::vector<uint8_t>(filtered_row_size * height);
+    auto const zero_row          = std::vector<uint8_t>(row_size, 0);
+    auto const row               = [&](size_t y) {
+        auto const source_y = flip_vertically ? height - 1 - y : y;
+        return std::span{data + source_y * row_size, row_size};
+    };
+
+    auto const jobs_count = (height + rows_per_job - 1) / rows_per_job;
+    parallel_for(jobs_count, options.threads_count, [&](size_t job) {
+        auto candidates = std::vector<uint8_t>(row_size * all_filters.size());
+        auto const end  = std::min(static_cast<size_t>(height), (job + 1) * rows_per_job);
+        for (size_t y = job * rows_per_job; y < end; ++y)
+        {
+            auto const current  = row(y);
+            auto const previous = y == 0 ? std::span<uint8_t const>{zero_row} : row(y - 1);
+            auto const out      = std::span{filtered}.subspan(y * filtered_row_size, filtered_row_size);
+            if (options.compression_level <= 0)
+            {
+                // Filtering is useless if we don't compress
+                out[0] = static_cast<uint8_t>(Filter::None);
+                std::copy(current.begin(), current.end(), out.begin() + 1);
+                continue;
+            }
+            auto best_filter = size_t{0};
+            auto best_score  = UINT64_MAX;
+            for (size_t i = 0; i < all_filters.size(); ++i)
+            {
+                auto const candidate = std::span{candidates}.subspan(i * row_size, row_size);
+                apply_filter(all_filters[i], current, previous, bytes_per_pixel, candidate);
+                auto const score = filter_score(candidate);
+                if (score < best_score)
+                {
+                    best_score  = score;
+                    best_filter = i;
+                }
+            }
+            out[0] = static_cast<uint8_t>(all_filters[best_filter]);
+            std::copy_n(candidates.begin() + static_cast<std::ptrdiff_t>(best_filter * row_size), row_size, out.begin() + 1);
+        }
+    });
+    return filtered;
+}
+
+} // namespace
+
+auto encode_png(Size::DataType width, Size::DataType height, void const* data, int channels_count, bool flip_vertically, PngOptions const& options) -> std::vector<std::vector<uint8_t>>
+{
+    auto const type = color_type(channels_count);
+    if (width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX)
+        throw std::runtime_error{"[img::save_png] Invalid image size: " + std::to_string(width) + "x" + std::to_string(height) + "."};
+
+    auto const filtered = filter_rows(width, height, static_cast<uint8_t const*>(data), static_cast<size_t>(channels_count), flip_vertically, options);
+    auto const pieces   = zlib_compress_pieces(filtered, std::clamp(options.compression_level, 0, 9), options.threads_count);
+
+    auto res = std::vector<std::vector<uint8_t>>(pieces.size() + 2);
+    // Signature + IHDR
+    {
+        auto header = std::array<uint8_t, 13>{};
+        write_u32_big_endian(width, header.data());
+        write_u32_big_endian(height, header.data() + 4);
+        header[8]  = 8; // Bit depth
+        header[9]  = type;
+        header[10] = 0; // Compression method
+        header[11] = 0; // Filter method
+        header[12] = 0; // Interlace method
+        res.front() = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        auto const ihdr = make_chunk("IHDR", header);
+        res.front().insert(res.front().end(), ihdr.begin(), ihdr.end());
+    }
+    // One IDAT per compressed piece. Decoders concatenate them, so the pieces don't need to be merged.
+    parallel_for(pieces.size(), options.threads_count, [&](size_t i) {
+        res[i + 1] = make_chunk("IDAT", pieces[i]);
+    });
+    res.back() = make_chunk("IEND", {});
+    return res;
+}
+
+} // namespace img::internal
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Save.h"
+
+namespace img::internal {
+
+/// Encodes an image as PNG.
+/// The file is returned as several buffers that must be written one after the other. This allows us to build the IDAT chunks in parallel without copying them all into one big buffer afterwards.
+/// Throws a std::runtime_error if channels_count is not between 1 and 4.
+auto encode_png(Size::DataType width, Size::DataType height, void const* data, int channels_count, bool flip_vertically, PngOptions const& options) -> std::vector<std::vector<uint8_t>>;
+
+} // namespace img::internal
@@ -1,11 +1,25 @@
 #include "Save.h"
 #include <stb_image/stb_image_write.h>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "Exr.h"
+#include "Png.h"
 
 namespace img {
 
-void save_png(std::filesystem::path const& file_path, Image const& image, bool flip_vertically)
+static void write_buffers_to_file(std::filesystem::path const& file_path, std::vector<std::vector<uint8_t>> const& buffers, char const* function_name)
 {
-    save_png(file_path, image.width(), image.height(), image.data(), image.channels_count(), flip_vertically);
+    auto file = std::ofstream{file_path, std::ios::binary};
+    for (auto const& buffer : buffers)
+        file.write(reinterpret_cast<char const*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    if (!file)
+        throw std::runtime_error{std::string{"["} + function_name + "] Couldn't write image to \"" + file_path.string() + "\"."};
+}
+
+void save_png(std::filesystem::path const& file_path, Image const& image, bool flip_vertically, PngOptions const& options)
+{
+    save_png(file_path, image.width(), image.height(), image.data(), image.channels_count(), flip_vertically, options);
 }
 
 void save_png(
@@ -14,36 +28,36 @@ void save_png(
     Size::DataType               height,
     const void*                  data,
     int                          channels_count,
-    bool                         flip_vertically
+    bool                         flip_vertically,
+    PngOptions const&            options
 )
 {
-    stbi_flip_vertically_on_write(flip_vertically ? 1 : 0);
-    stbi_write_png(file_path.string().c_str(), static_cast<int>(width), static_cast<int>(height), channels_count, data, 0);
+    write_buffers_to_file(file_path, internal::encode_png(width, height, data, channels_count, flip_vertically, options), "img::save_png");
 }
 
-auto save_png_to_string(Image const& image, bool flip_vertically) -> std::string
+auto save_png_to_string(Image const& image, bool flip_vertically, PngOptions const& options) -> std::string
 {
-    return save_png_to_string(image.width(), image.height(), image.data(), image.channels_count(), flip_vertically);
-}
-
-static void write_to_string(void* context, void* data, int size)
-{
-    auto& str = *reinterpret_cast<std::string*>(context);
-    str += std::string{reinterpret_cast<char*>(data), static_cast<size_t>(size)};
+    return save_png_to_string(image.width(), image.height(), image.data(), image.channels_count(), flip_vertically, options);
 }
 
 auto save_png_to_string(
-    Size::DataType width,
-    Size::DataType height,
-    const void*    data,
-    int            channels_count,
-    bool           flip_vertically
+    Size::DataType    width,
+    Size::DataType    height,
+    const void*       data,
+    int               channels_count,
+    bool              flip_vertically,
+    PngOptions const& options
 ) -> std::string
 {
-    stbi_flip_vertically_on_write(flip_vertically ? 1 : 0);
+    auto const buffers = internal::encode_png(width, height, data, channels_count, flip_vertically, options);
 
+    size_t total_size = 0;
+    for (auto const& buffer : buffers)
+        total_size += buffer.size();
     std::string res{};
-    stbi_write_png_to_func(&write_to_string, &res, static_cast<int>(width), static_cast<int>(height), channels_count, data, 0);
+    res.reserve(total_size);
+    for (auto const& buffer : buffers)
+        res.append(reinterpret_cast<char const*>(buffer.data()), buffer.size());
     return res;
 }
 
@@ -61,8 +75,32 @@ void save_jpeg(
     bool                         flip_vertically
 )
 {
-    stbi_flip_vertically_on_write(flip_vertically ? 1 : 0);
-    stbi_write_jpg(file_path.string().c_str(), static_cast<int>(width), static_cast<int>(height), channels_count, data, 100);
+    // We don't use stbi_flip_vertically_on_write() because it is a global setting, which would prevent us from saving several images in parallel.
+    auto flipped = std::vector<uint8_t>{};
+    if (flip_vertically)
+    {
+        auto const row_size = static_cast<size_t>(width) * static_cast<size_t>(channels_count);
+        auto const* rows    = static_cast<uint8_t const*>(data);
+        flipped.resize(row_size * height);
+        for (size_t y = 0; y < height; ++y)
+            std::copy_n(rows + (height - 1 - y) * row_size, row_size, flipped.begin() + static_cast<std::ptrdiff_t>(y * row_size));
+        data = flipped.data();
+    }
+    if (!stbi_write_jpg(file_path.string().c_str(), static_cast<int>(width), static_cast<int>(height), channels_count, data, 100))
+        throw std::runtime_error{"[img::save_jpeg] Couldn't write image to \"" + file_path.string() + "\"."};
+}
+
+void save_exr(
+    std::filesystem::path const& file_path,
+    Size::DataType               width,
+    Size::DataType               height,
+    float const*                 data,
+    int                          channels_count,
+    bool                         flip_vertically,
+    ExrOptions const&            options
+)
+{
+    write_buffers_to_file(file_path, internal::encode_exr(width, height, data, channels_count, flip_vertically, options), "img::save_exr");
 }
 
-} // namespace img
\ No newline at end of file
+} // namespace img
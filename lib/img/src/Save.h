@@ -1,15 +1,47 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include "Image.h"
 
 namespace img {
 
+struct PngOptions {
+    /// From 0 (no compression, fastest) to 9 (smallest files, slowest).
+    int compression_level{6};
+    /// Number of threads used to filter and compress the image. 0 means one per hardware thread.
+    size_t threads_count{0};
+};
+
+enum class ExrPixelType {
+    Half,  // 16-bit floats: half the size, and enough precision for most HDR images
+    Float, // 32-bit floats
+};
+
+enum class ExrCompression {
+    None,
+    ZIPS, // Deflate, one scanline at a time
+    ZIP,  // Deflate, 16 scanlines at a time. Usually compresses better than ZIPS.
+};
+
+struct ExrOptions {
+    ExrPixelType   pixel_type{ExrPixelType::Half};
+    ExrCompression compression{ExrCompression::ZIP};
+    /// If 0 the image is stored as scanlines, otherwise as square tiles of tile_size x tile_size pixels.
+    uint32_t tile_size{0};
+    /// From 1 (fastest) to 9 (smallest files). Only used by ZIP and ZIPS.
+    int compression_level{6};
+    /// Number of threads used to compress the image. 0 means one per hardware thread.
+    size_t threads_count{0};
+};
+
 /// Saves an image as PNG.
 /// Throws a std::runtime_error if writing to the file fails.
 /// @param file_path The destination path for the image: something like "out/myImage.png". The folders in the path must exist.
 /// @param flip_vertically By default we use the OpenGL convention: the first row should be the bottom of the image. You can set flip_vertically to false if your first row is at the top of the image.
-void save_png(std::filesystem::path const& file_path, Image const& image, bool flip_vertically = true);
+/// @param options The compression level and the number of threads used to encode the image.
+void save_png(std::filesystem::path const& file_path, Image const& image, bool flip_vertically = true, PngOptions const& options = {});
 
 /// Saves an image as PNG.
 /// Throws a std::runtime_error if writing to the file fails.
@@ -19,17 +51,20 @@ void save_png(std::filesystem::path const& file_path, Image const& image, bool f
 /// @param data An array of uint8_t representing the image. The pixels should be written sequentially, row after row. Something like [255, 200, 100, 255, 120, 30, 80, 255, ...] where (255, 200, 100, 255) would be the first pixel and (120, 30, 80, 255) the second pixel and so on.
 /// @param channels_count The number of channels per pixel, e.g. 4 if the format is RGBA.
 /// @param flip_vertically By default we use the OpenGL convention: the first row should be the bottom of the image. You can set flip_vertically to false if your first row is at the top of the image.
-void save_png(std::filesystem::path const& file_path, Size::DataType width, Size::DataType height, void const* data, int channels_count, bool flip_vertically = true);
+/// @param options The compression level and the number of threads used to encode the image.
+void save_png(std::filesystem::path const& file_path, Size::DataType width, Size::DataType height, void const* data, int channels_count, bool flip_vertically = true, PngOptions const& options = {});
 
 /// Returns a string containing the image data in PNG format.
 /// @param flip_vertically By default we use the OpenGL convention: the first row should be the bottom of the image. You can set flip_vertically to false if your first row is at the top of the image.
-auto save_png_to_string(Image const& image, bool flip_vertically = true) -> std::string;
+/// @param options The compression level and the number of threads used to encode the image.
+auto save_png_to_string(Image const& image, bool flip_vertically = true, PngOptions const& options = {}) -> std::string;
 
 /// Returns a string containing the image data in PNG format.
 /// @param data An array of uint8_t representing the image. The pixels should be written sequentially, row after row. Something like [255, 200, 100, 255, 120, 30, 80, 255, ...] where (255, 200, 100, 255) would be the first pixel and (120, 30, 80, 255) the second pixel and so on.
 /// @param channels_count The number of channels per pixel, e.g. 4 if the format is RGBA.
 /// @param flip_vertically By default we use the OpenGL convention: the first row should be the bottom of the image. You can set flip_vertically to false if your first row is at the top of the image.
-auto save_png_to_string(Size::DataType width, Size::DataType height, void const* data, int channels_count, bool flip_vertically = true) -> std::string;
+/// @param options The compression level and the number of threads used to encode the image.
+auto save_png_to_string(Size::DataType width, Size::DataType height, void const* data, int channels_count, bool flip_vertically = true, PngOptions const& options = {}) -> std::string;
 
 /// Saves an image as JPEG.
 /// Throws a std::runtime_error if writing to the file fails.
@@ -47,4 +82,15 @@ void save_jpeg(std::filesystem::path const& file_path, Image const& image, bool
 /// @param flip_vertically By default we use the OpenGL convention: the first row should be the bottom of the image. You can set flip_vertically to false if your first row is at the top of the image.
 void save_jpeg(std::filesystem::path const& file_path, Size::DataType width, Size::DataType height, void const* data, int channels_count, bool flip_vertically = true);
 
+/// Saves an HDR image as OpenEXR.
+/// Throws a std::runtime_error if writing to the file fails.
+/// @param file_path The destination path for the image: something like "out/myImage.exr". The folders in the path must exist.
+/// @param width The width in pixels of the image represented by data.
+/// @param height The height in pixels of the image represented by data.
+/// @param data An array of floats representing the image, in linear color space. The pixels should be written sequentially, row after row, like for the other save functions. This is exactly what you get when you read back a GL_RGBA32F texture with GL_FLOAT.
+/// @param channels_count The number of channels per pixel in data: 1 (Y), 2 (YA), 3 (RGB) or 4 (RGBA).
+/// @param flip_vertically By default we use the OpenGL convention: the first row should be the bottom of the image. You can set flip_vertically to false if your first row is at the top of the image.
+/// @param options The type of the channels in the file, the layout, the compression and the number of threads used to encode the image.
+void save_exr(std::filesystem::path const& file_path, Size::DataType width, Size::DataType height, float const* data, int channels_count, bool flip_vertically = true, ExrOptions const& options = {});
+
 } // namespace img
\ No newline at end of file
@@ -0,0 +1,21 @@
+// The camera of default.frag: a position, a rotation in degrees (x is the yaw, y the pitch and z the roll),
+// and a zoom, which is the distance between the eye and a screen that is 1 unit high.
+
+#include "rotation.glsl"
+
+mat3 cameraRotationMatrix(vec3 rotation) {
+    return Pitch(radians(rotation.y)) * Yaw(radians(rotation.x)) * Roll(radians(rotation.z));
+}
+
+// Direction of the ray that goes through the pixel at fragCoord
+vec3 cameraRayDirection(vec2 fragCoord, vec2 resolution, vec3 rotation, float zoom) {
+    vec2 uv = (fragCoord - 0.5 * resolution) / resolution.y;
+    return normalize(vec3(uv, zoom)) * cameraRotationMatrix(rotation);
+}
+
+// Inverse of cameraRayDirection(): xy is the pixel that looks in this direction, and z is negative if the direction is behind the camera
+vec3 cameraProjectDirection(vec3 direction, vec2 resolution, vec3 rotation, float zoom) {
+    vec3 local = cameraRotationMatrix(rotation) * direction;
+    vec2 uv = local.xy / local.z * zoom;
+    return vec3(uv * resolution.y + 0.5 * resolution, local.z);
+}
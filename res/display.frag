@@ -3,6 +3,8 @@
 uniform sampler2D tex;
 uniform vec2 resolution;
 
+out vec4 FragColor;
+
 void main() {
-	gl_FragColor = texture(tex, gl_FragCoord.xy / resolution);
+	FragColor = texture(tex, gl_FragCoord.xy / resolution);
 }
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 330 core
+
+// Draws a single triangle that covers the whole screen, without any vertex buffer. See draw_fullscreen_triangle().
+// (A triangle rather than a quad avoids the pixels on the diagonal being shaded twice.)
+
+out vec2 uv;
+
+void main()
+{
+    uv          = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2. - 1., 0., 1.);
+}
@@ -0,0 +1,418 @@
+// The scene and the materials of the path tracer, shared by default.frag and the stages of the WavefrontPathTracer.
+// The random numbers come from sampler.glsl: call startSample() before tracing a sample.
+// NEXT_EVENT_ESTIMATION: at each diffuse bounce, also send a shadow ray towards a light picked by LightSampler, see directLight()
+
+#ifdef SHOW_NORMALS
+const bool showNormals = true;
+#else
+const bool showNormals = false;
+#endif
+#ifdef PLANE_GRID
+const bool planeGrid = true;
+#else
+const bool planeGrid = false;
+#endif
+
+const int MAX_OBJECTS = 30;
+const int ELEMENTS_IN_1OBJ = 23;
+uniform float objects[MAX_OBJECTS*ELEMENTS_IN_1OBJ];
+
+#define MAX_DIST 1000.0
+#define PI 3.141592
+
+float degree = 2.0 * PI / 360.0;
+
+uniform vec3 skyboxRotation;
+uniform sampler2D skybox;
+uniform bool useSkyboxColor;
+uniform vec3 skyboxColor;
+uniform float highestColValue;
+uniform vec3 gridCol2;
+uniform float tileSize;
+uniform float treshHoldIntensity;
+
+vec3 bloomWeights = vec3(0.2126, 0.7152, 0.0722);
+
+struct Sdf {
+    float d;
+    float d2;
+    vec3 n;
+    vec3 n2;
+};
+
+struct Ray {
+    Sdf sdf;
+    vec3 col;
+    vec3 specularCol;
+    vec3 pos;
+    float percentSpecular;
+    float roughness;
+    float refractionIndex;
+    float reflectivity;
+    float isLight;
+    float type;
+    float index; // In objects
+};
+
+// Outputs of ShadeHit() for next-event estimation
+vec3 DIRECT_LIGHT;        // The light that the shadow ray found, to add to the path after multiplying it by the throughput of the path before this hit
+float LAST_BSDF_PDF = 0.0; // The probability density of the direction of the current ray, or 0 if it didn't come from a diffuse bounce. Reset it to 0 when starting a path.
+
+#include "sampler.glsl"
+
+float random() {
+	return nextSample();
+}
+
+vec3 randomOnSphere() {
+	vec3 rand = vec3(random(), random(), random());
+	float theta = rand.x * 2.0 * 3.14159265;
+	float v = rand.y;
+	float phi = acos(2.0 * v - 1.0);
+	float r = pow(rand.z, 1.0 / 3.0);
+	float x = r * sin(phi) * cos(theta);
+	float y = r * sin(phi) * sin(theta);
+	float z = r * cos(phi);
+	return vec3(x, y, z);
+}
+
+#include "rotation.glsl"
+
+vec3 applySkyBox(vec3 rd, sampler2D skybox) {
+    if (useSkyboxColor) return skyboxColor;
+    rd *= Pitch(skyboxRotation[0] * degree);
+    rd *= Yaw(skyboxRotation[1] * degree);
+    rd *= Roll(skyboxRotation[2] * degree);
+    // Convert the ray direction to 2D texture coordinates
+    vec2 st;
+    st.x = 0.5 + atan(rd.z, rd.x) / (2.0 * PI);
+    st.y = 0.5 - asin(rd.y) / PI;
+    // Sample the cube map using the texture coordinates
+    vec3 col = texture(skybox, st).rgb;
+
+    col = clamp(col, 0.0, highestColValue);
+
+    return col;
+}
+
+Ray Min(Ray minIt, Ray obj) {
+    return (obj.sdf.d > 0.0 && obj.sdf.d < minIt.sdf.d) ? obj : minIt;
+}
+
+Sdf sdSphere( in vec3 ro, in vec3 rd, in vec3 ce, float ra ) {
+    vec3 oc = ro - ce;
+    float b = dot( oc, rd );
+    vec3 qc = oc - b*rd;
+    float h = ra*ra - dot( qc, qc );
+    // no intersection
+    if( h<0.0 ) return Sdf(MAX_DIST, MAX_DIST, vec3(-1.0), vec3(0));
+    h = sqrt( h );
+    float d = -b - h;
+    float d2 = -b + h;
+    // normal of the nearest hit
+    vec3 n = normalize((ro + rd * (d - 0.001)) - ce);
+    // normal of the farest hit
+    vec3 n2 = normalize((ro + rd * (d2 - 0.001)) - ce);
+
+    return Sdf(d, d2, n, n2);
+}
+
+Sdf sdCube( in vec3 ro, in vec3 rd, in vec3 ce, vec3 boxSize, float IOR) {   
+    ro -= ce;
+    vec3 m = 1.0/rd;
+    vec3 n = m*ro;
+    vec3 k = abs(m)*boxSize;
+    vec3 t1 = -n - k;
+    vec3 t2 = -n + k;
+    float tN = max( max( t1.x, t1.y ), t1.z );
+    float tF = min( min( t2.x, t2.y ), t2.z );
+    // no intersection
+    if( tN>tF || tF<0.0) return Sdf(MAX_DIST, MAX_DIST, vec3(0), vec3(0));
+    // normal of the nearest hit
+    vec3 N = (tN>0.0) ? step(vec3(tN),t1) : step(t2,vec3(tF));
+    N *= -sign(rd);
+    // normal of the farest hit
+    // there is no need to calculate object's N2 if it is not a lense as it will not be used
+    vec3 N2 = vec3(0);
+    if (IOR != -1.0){
+        N2 = (tF > 0.0) ? step(t1, vec3(tN)) : step(vec3(tF), t2);
+        N2 *= sign(rd);
+    }
+
+    return Sdf(tN, tF, N, N2);
+}
+
+Sdf sdPlane(in vec3 ro, in vec3 rd, in vec4 p) {
+	float d = -(dot(ro, p.xyz) + p.w) / dot(rd, p.xyz);
+    return Sdf(d, d, p.xyz, vec3(0));
+}
+
+float fresnelReflectAmount (vec3 rd, vec3 normal, float n1, float n2, float object_reflectivity) {
+        // Schlick aproximation
+        float r0 = (n1-n2) / (n1+n2);
+        r0 *= r0;
+        float cosX = -dot(normal, rd);
+        if (n1 > n2)
+        {
+            float n = n1/n2;
+            float sinT2 = n*n*(1.0-cosX*cosX);
+            // Total internal reflection
+            if (sinT2 > 1.0)
+                return 1.0;
+            cosX = sqrt(1.0-sinT2);
+        }
+        float x = 1.0-cosX;
+        float ret = r0+(1.0-r0)*x*x*x*x*x;
+ 
+        ret = (object_reflectivity + (1.0-object_reflectivity) * ret);
+        return ret;
+}
+
+Ray GetClosestObj(vec3 ro, vec3 rd) {
+    Ray minIt;
+    minIt.sdf.d = MAX_DIST;
+    minIt.index = -1.0;
+    // x, y, z, r, g, b, type, radius, cubeSize, isLigjt, reflectivity, refract, specularPercent, roughtness, powerOfLight, rotation, specularColour
+	// 1  2  3  4  5  6    7     8     9 10 11     12         13          14          15             16            17       18 19 20     21 22 23
+    for (int i=0; i<MAX_OBJECTS; i++){
+        if (objects[6 + i * ELEMENTS_IN_1OBJ] != 0.0){
+            Ray object;
+            int ind = i * ELEMENTS_IN_1OBJ;
+            object.index = float(i);
+
+            // common properties
+            vec3 pos = vec3(objects[ind], objects[1 + ind], objects[2 + ind]);
+            object.col = vec3(objects[3 + ind], objects[4 + ind], objects[5 + ind]);
+            object.specularCol = vec3(objects[20 + ind], objects[21 + ind], objects[22 + ind]);
+
+            // choosing the material
+            object.isLight = objects[11 + ind];
+            if (object.isLight == 1.0) object.col *= objects[16 + ind];
+            object.refractionIndex = objects[13 + ind];
+            object.reflectivity = objects[12 + ind];
+            object.roughness = objects[15 + ind];
+            object.percentSpecular = objects[14 + ind];
+            
+            // choosing the sdf
+            if (objects[6 + ind] == 1.0) {
+                // sphere
+                object.sdf = sdSphere(ro, rd, pos, objects[7 + ind]);
+                object.type = 1.0;
+            } 
+            else if (objects[6 + ind] == 2.0) {
+                // cube
+                mat3 rotMat = Pitch(objects[17 + ind] * degree) * Yaw(objects[18 + ind] * degree) * Roll(objects[19 + ind] * degree);
+                object.sdf = sdCube((ro-pos) * rotMat, rd * rotMat, vec3(0), vec3(objects[8 + ind], objects[9 + ind], objects[10 + ind]), object.refractionIndex);
+                rotMat = transpose(inverse(rotMat));
+                object.sdf.n = normalize(rotMat * object.sdf.n);
+                if (object.refractionIndex != -1.0){
+                    object.sdf.n2 = normalize(rotMat * object.sdf.n2);
+                }
+                object.type = 2.0;
+            } 
+            else if (objects[6 + ind] == 3.0) {
+                // plane
+                object.sdf = sdPlane(ro, rd, vec4(0, 1, 0, -1.0 * pos.y));
+                object.type = 3.0;
+            }
+            minIt = Min(minIt, object);
+            minIt.pos = pos;
+        }
+    }
+
+    return minIt;
+}
+
+#ifdef NEXT_EVENT_ESTIMATION
+// Built by LightSampler. Row 0 is an alias table that picks the lights proportionally to their power:
+// x is the probability to keep the entry, y the entry to use otherwise, z the index of the light in objects, and w the probability to pick that light.
+// Row 1 gives the probability to pick each object (0 if it isn't a light, or if it is a plane).
+uniform sampler2D lightTable;
+uniform int lightsCount;
+
+// The diffuse bounce of ShadeHit() multiplies the path by the color of the surface, and picks its direction uniformly in the hemisphere:
+// so it behaves like a BSDF (times the cosine) of col / (2 PI), sampled with this probability density.
+const float DIFFUSE_PDF = 1.0 / (2.0 * PI);
+
+float powerHeuristic(float pdf, float otherPdf) {
+    return pdf * pdf / (pdf * pdf + otherPdf * otherPdf);
+}
+
+mat3 cubeRotation(int ind) {
+    return Pitch(objects[17 + ind] * degree) * Yaw(objects[18 + ind] * degree) * Roll(objects[19 + ind] * degree);
+}
+
+float cubeArea(vec3 halfSize) {
+    return 8.0 * (halfSize.x * halfSize.y + halfSize.y * halfSize.z + halfSize.z * halfSize.x);
+}
+
+// The cosine of the half-angle of the cone of directions from p that hit the sphere, or 1 if p is inside it
+float sphereCosThetaMax(vec3 p, vec3 center, float radius) {
+    vec3 toCenter = center - p;
+    float sinThetaMax2 = radius * radius / dot(toCenter, toCenter);
+    return sinThetaMax2 >= 1.0 ? 1.0 : sqrt(1.0 - sinThetaMax2);
+}
+
+// The probability density (per solid angle) that sampleLight() picks the ray from p that hits light at distance d, on a surface of normal n
+float lightPdf(int light, vec3 p, vec3 rd, float d, vec3 n) {
+    float selectionPdf = texelFetch(lightTable, ivec2(light, 1), 0).x;
+    if (selectionPdf == 0.0) return 0.0;
+    int ind = light * ELEMENTS_IN_1OBJ;
+    if (objects[6 + ind] == 1.0) {
+        float cosThetaMax = sphereCosThetaMax(p, vec3(objects[ind], objects[1 + ind], objects[2 + ind]), objects[7 + ind]);
+        return cosThetaMax == 1.0 ? 0.0 : selectionPdf / (2.0 * PI * (1.0 - cosThetaMax));
+    }
+    return selectionPdf * d * d / (abs(dot(n, rd)) * cubeArea(vec3(objects[8 + ind], objects[9 + ind], objects[10 + ind])));
+}
+
+// Picks a light proportionally to its power, and a direction from p towards it. Returns false if there is no light to pick from p.
+bool sampleLight(vec3 p, out int light, out vec3 wi, out float pdf) {
+    if (lightsCount == 0) return false;
+    int entry = min(int(random() * float(lightsCount)), lightsCount - 1);
+    vec4 picked = texelFetch(lightTable, ivec2(entry, 0), 0);
+    if (random() >= picked.x) picked = texelFetch(lightTable, ivec2(int(picked.y), 0), 0);
+    light = int(picked.z);
+    pdf = picked.w;
+
+    int ind = light * ELEMENTS_IN_1OBJ;
+    vec3 pos = vec3(objects[ind], objects[1 + ind], objects[2 + ind]);
+    if (objects[6 + ind] == 1.0) {
+        // Sphere: uniformly in the cone of directions that hit it
+        float cosThetaMax = sphereCosThetaMax(p, pos, objects[7 + ind]);
+        if (cosThetaMax == 1.0) return false;
+        float cosTheta = 1.0 - random() * (1.0 - cosThetaMax);
+        float sinTheta = sqrt(max(0.0, 1.0 - cosTheta * cosTheta));
+        float phi = random() * 2.0 * PI;
+        vec3 w = normalize(pos - p);
+        vec3 t = normalize(cross(abs(w.x) > 0.5 ? vec3(0, 1, 0) : vec3(1, 0, 0), w));
+        vec3 b = cross(w, t);
+        wi = normalize(t * cos(phi) * sinTheta + b * sin(phi) * sinTheta + w * cosTheta);
+        pdf /= 2.0 * PI * (1.0 - cosThetaMax);
+        return true;
+    }
+
+    // Cube: uniformly on its surface. First pick a face proportionally to its area, then a point on it.
+    vec3 halfSize = vec3(objects[8 + ind], objects[9 + ind], objects[10 + ind]);
+    vec3 facesArea = vec3(halfSize.y * halfSize.z, halfSize.z * halfSize.x, halfSize.x * halfSize.y);
+    float u = random() * (facesArea.x + facesArea.y + facesArea.z);
+    int axis = u < facesArea.x ? 0 : (u < facesArea.x + facesArea.y ? 1 : 2);
+    float side = random() < 0.5 ? -1.0 : 1.0;
+    vec3 localNormal = vec3(0);
+    localNormal[axis] = side;
+    vec3 localPoint = (vec3(random(), random(), random()) * 2.0 - 1.0) * halfSize;
+    localPoint[axis] = side * halfSize[axis];
+    mat3 rotMat = cubeRotation(ind); // See GetClosestObj(): the cube is intersected in its local space, (p - pos) * rotMat
+    vec3 toPoint = pos + rotMat * localPoint - p;
+    float d = length(toPoint);
+    wi = toPoint / d;
+    float cosLight = -dot(rotMat * localNormal, wi);
+    if (cosLight <= 0.0) return false; // We picked a face that doesn't face p
+    pdf *= d * d / (cosLight * cubeArea(halfSize));
+    return true;
+}
+
+// The light that reaches the diffuse surface at p (of normal n and color col) directly from a light, weighted against the diffuse bounce with multiple importance sampling
+vec3 directLight(vec3 p, vec3 n, vec3 col) {
+    int light;
+    vec3 wi;
+    float pdf;
+    if (!sampleLight(p, light, wi, pdf) || dot(wi, n) <= 0.0) return vec3(0); // The diffuse bounce never goes below the surface
+    Ray shadowRay = GetClosestObj(p, wi);
+    if (int(shadowRay.index) != light) return vec3(0); // Something is in the way
+    return col * DIFFUSE_PDF * shadowRay.col / pdf * powerHeuristic(pdf, DIFFUSE_PDF);
+}
+#endif
+
+// What happens to a ray when it hits minIt: returns the color it takes, and moves ro and rd to the next ray of the path.
+// minIt.sdf.d is MAX_DIST if the path stops there (the ray went to the sky or hit a light).
+Ray ShadeHit(Ray minIt, inout vec3 ro, inout vec3 rd){
+    DIRECT_LIGHT = vec3(0);
+    float previousBsdfPdf = LAST_BSDF_PDF;
+    LAST_BSDF_PDF = 0.0;
+    if (showNormals) minIt.col = minIt.sdf.n;
+
+    // if hit sky
+    if (minIt.sdf.d == MAX_DIST) {
+        minIt.col = applySkyBox(rd, skybox);
+        return minIt;
+    }
+    
+    // if hit a light source
+    if (minIt.isLight == 1.0){
+#ifdef NEXT_EVENT_ESTIMATION
+        // The shadow rays could have found this light too
+        if (previousBsdfPdf > 0.0) minIt.col *= powerHeuristic(previousBsdfPdf, lightPdf(int(minIt.index), ro, rd, minIt.sdf.d, minIt.sdf.n));
+#endif
+        minIt.sdf.d = MAX_DIST;
+        return minIt;
+    };
+        
+    // refraction
+    if (minIt.refractionIndex != -1.0 && !showNormals) {
+        ro += rd * (minIt.sdf.d - 0.001);  // move ro to the hit pos
+
+        // calculate how much light is reflected
+        float rFloat = fract(random());
+        float fresnel = fresnelReflectAmount(rd, minIt.sdf.n, 1.01, minIt.refractionIndex, minIt.reflectivity);
+        if (rFloat < fresnel * fresnel){
+            minIt.col = minIt.specularCol;
+            rd = reflect(rd, minIt.sdf.n);
+            return minIt;
+        }
+
+        // refract the rd
+        rd = refract(rd, minIt.sdf.n, 1.01 / minIt.refractionIndex);
+            
+        // get the second distance, the hit we cant see
+        minIt = GetClosestObj(ro, rd);
+
+        // and move the ro there
+        ro += rd * (minIt.sdf.d2 + 0.001);
+        // refrect the distance again as light isrefracted twice, both when enters the glass and leaves it
+        rd = refract(rd, -minIt.sdf.n2, minIt.refractionIndex / 1.01);
+
+        return minIt;
+    }
+    // move the ray origin to the point of hit
+    ro += rd * (minIt.sdf.d - 0.001);
+
+    // plane grid
+    if (minIt.type == 3.0 && planeGrid){
+        float tile = mod(floor(ro.x / tileSize) + floor(ro.z / tileSize), 2.0);
+        if (tile == 1.0) minIt.col = gridCol2;
+    }
+
+    vec3 rOnSphere = randomOnSphere(); // random ray direction
+    bool doSpecular = fract(random()) < minIt.percentSpecular;
+
+    //  if specular reflection
+    if (doSpecular){
+        vec3 specular = reflect(rd, minIt.sdf.n);
+        vec3 diffuse = normalize(rOnSphere * dot(rOnSphere, minIt.sdf.n));
+        rd = mix(specular, diffuse, minIt.roughness);
+        if (minIt.type != 3.0) minIt.col = minIt.specularCol; // specular colour
+    } else {
+        rd = normalize(rOnSphere * dot(rOnSphere, minIt.sdf.n));
+#ifdef NEXT_EVENT_ESTIMATION
+        DIRECT_LIGHT = directLight(ro, minIt.sdf.n, minIt.col);
+        LAST_BSDF_PDF = DIFFUSE_PDF;
+#endif
+    }
+
+    return minIt;
+}
+
+Ray CastRay(inout vec3 ro, inout vec3 rd){
+    return ShadeHit(GetClosestObj(ro, rd), ro, rd);
+}
+
+// ShadeHit() takes a different branch for these hits, so the wavefront path tracer shades them separately
+bool IsRefractive(Ray minIt) {
+    return minIt.refractionIndex != -1.0 && !showNormals;
+}
+
+// The pixels that glow, see Bloom
+vec4 brightPixels(vec3 col) {
+    float brightness = dot(col, bloomWeights * treshHoldIntensity);
+    return brightness > 1.0 ? vec4(col, 1.0) : vec4(0.0);
+}
@@ -0,0 +1,28 @@
+// Rotation matrices around the X, Y and Z axes
+
+mat3 Pitch(float a) {
+    float Sin = sin(a);
+    float Cos = cos(a);
+
+    return mat3(1, 0, 0,
+                0, Cos, -Sin,
+                0, Sin, Cos);
+}
+
+mat3 Yaw(float a) {
+    float Sin = sin(a);
+    float Cos = cos(a);
+
+    return mat3(Cos, 0, Sin,
+                0, 1, 0,
+                -Sin, 0, Cos);
+}
+
+mat3 Roll(float a) {
+    float Sin = sin(a);
+    float Cos = cos(a);
+
+    return mat3(Cos, -Sin, 0,
+                Sin, Cos, 0,
+                0, 0, 1);
+}
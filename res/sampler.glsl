@@ -0,0 +1,67 @@
+// Random numbers of the path tracer: an Owen-scrambled Sobol sequence, rotated by a blue noise in each pixel. See LowDiscrepancySampler, which must be kept in sync.
+// Call startSample() before tracing each sample of a pixel, then nextSample() gives the next dimension of that sample.
+#define SOBOL_DIMENSIONS_COUNT 4u
+
+uniform usampler2D sobolMatrices; // One row per dimension, one column per bit of the sample index
+uniform usampler2D blueNoise;     // The rank of each pixel in a void-and-cluster blue noise tile
+uniform uint frameIndex;          // 0 when the accumulation starts over
+
+uint SAMPLE_INDEX;
+uint SAMPLE_DIMENSION;
+ivec2 SAMPLE_PIXEL;
+
+uint reverseBits(uint x) { // bitfieldReverse() needs GLSL 4.00
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Owen scrambling, see "Practical Hash-based Owen Scrambling", Burley 2020
+uint nestedUniformScramble(uint x, uint seed) {
+    x = reverseBits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverseBits(x);
+}
+
+uint sobol(uint index, uint dimension) {
+    uint res = 0u;
+    for (int bit = 0; index != 0u; bit++, index >>= 1) {
+        if ((index & 1u) != 0u) res ^= texelFetch(sobolMatrices, ivec2(bit, int(dimension)), 0).r;
+    }
+    return res;
+}
+
+void startSample(ivec2 pixel, uint sampleIndex) {
+    SAMPLE_PIXEL = pixel;
+    SAMPLE_INDEX = sampleIndex;
+    SAMPLE_DIMENSION = 0u;
+}
+
+float nextSample() {
+    uint dimension = SAMPLE_DIMENSION++;
+    // The dimensions past SOBOL_DIMENSIONS_COUNT reuse the first ones, with a differently shuffled index
+    uint index = nestedUniformScramble(SAMPLE_INDEX, hash(dimension / SOBOL_DIMENSIONS_COUNT));
+    uint scrambled = nestedUniformScramble(sobol(index, dimension % SOBOL_DIMENSIONS_COUNT), hash(dimension + 0x9e3779b9u));
+
+    // Each dimension reads the blue noise at a different offset (given by the R2 sequence), otherwise they would all be correlated
+    int blueNoiseSize = textureSize(blueNoise, 0).x;
+    ivec2 offset = ivec2(fract(float(dimension) * vec2(0.7548776662, 0.5698402910)) * float(blueNoiseSize));
+    uint rank = texelFetch(blueNoise, (SAMPLE_PIXEL + offset) % blueNoiseSize, 0).r;
+    float rotation = (float(rank) + 0.5) / float(blueNoiseSize * blueNoiseSize);
+    return min(fract(float(scrambled) * exp2(-32.0) + rotation), 0.99999994);
+}
@@ -0,0 +1,62 @@
+#version 330 core
+
+// Blends the new samples of default.frag (compiled with TEMPORAL_REPROJECTION) into the image accumulated during the previous frames.
+// When the camera moves, the history is reprojected: we look it up where the surface seen by the pixel was on the screen during the previous frame.
+// The history is then clamped to the colors of the new samples around the pixel, so that what has just become visible doesn't get smeared with what was there before.
+
+#include "camera.glsl"
+
+uniform sampler2D currentSamples; // The samples of this frame
+uniform sampler2D primaryHits;    // The PrimaryHit output of default.frag
+uniform sampler2D history;        // rgb is the accumulated color, and a the number of frames it contains
+uniform vec2 resolution;
+uniform vec3 previousCameraPosition;
+uniform vec3 previousCameraRotation;
+uniform float previousZoom;
+uniform bool cameraMoved;
+uniform float maxHistoryLength; // While the camera moves, the history weighs at most this many frames, so that the errors of the reprojection fade out quickly
+uniform float clippingStrength; // Size of the box the history is clamped to, in standard deviations of the neighborhood
+
+out vec4 FragColor;
+
+vec4 accumulate(vec4 previous, vec3 current, float maxCount) {
+    float count = min(previous.a, maxCount) + 1.0;
+    return vec4(mix(previous.rgb, current, 1.0 / count), count);
+}
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 current = texelFetch(currentSamples, pixel, 0).rgb;
+
+    // The pixels still look at the same thing: plain progressive accumulation
+    if (!cameraMoved) {
+        FragColor = accumulate(texelFetch(history, pixel, 0), current, 1e30);
+        return;
+    }
+
+    vec4 hit = texelFetch(primaryHits, pixel, 0);
+    vec3 direction = hit.w > 0.5 ? hit.xyz - previousCameraPosition : hit.xyz; // The sky is infinitely far away, only the rotation of the camera moves it
+    vec3 previousPixel = cameraProjectDirection(direction, resolution, previousCameraRotation, previousZoom);
+    if (previousPixel.z <= 0.0 || any(lessThan(previousPixel.xy, vec2(0.0))) || any(greaterThanEqual(previousPixel.xy, resolution))) {
+        FragColor = vec4(current, 1.0); // It was off-screen, there is no history
+        return;
+    }
+    vec4 previous = texture(history, previousPixel.xy / resolution);
+
+    // Variance clipping: clamp the history to the mean of the neighborhood, plus or minus a few standard deviations
+    vec3 m1 = vec3(0.0);
+    vec3 m2 = vec3(0.0);
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            vec3 c = texelFetch(currentSamples, clamp(pixel + ivec2(x, y), ivec2(0), ivec2(resolution) - 1), 0).rgb;
+            m1 += c;
+            m2 += c * c;
+        }
+    }
+    m1 /= 9.0;
+    m2 /= 9.0;
+    vec3 sigma = sqrt(max(m2 - m1 * m1, 0.0));
+    previous.rgb = clamp(previous.rgb, m1 - clippingStrength * sigma, m1 + clippingStrength * sigma);
+
+    FragColor = accumulate(previous, current, maxHistoryLength);
+}
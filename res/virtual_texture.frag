@@ -0,0 +1,48 @@
+#version 430
+
+// Same as fragment.glsl, but reads the color from a VirtualTexture.
+// See VirtualTexture::set_uniform().
+
+struct VirtualTexture {
+    usampler2D page_table;       // For each page: (physical page x, physical page y, level of the page that is actually resident, 1)
+    sampler2D  physical_texture; // The cache that contains the resident pages
+    vec2       virtual_size;     // Size of the level 0, in texels
+    vec2       uv_scale;
+    float      page_size;
+    float      border;
+    float      max_level;
+    vec2       physical_size;
+};
+
+uniform VirtualTexture my_texture;
+uniform vec3           light_direction;
+
+out vec4 out_color;
+in vec3  position_ws;
+in vec2  uv;
+in vec3  normal;
+
+vec4 sample_virtual_texture(VirtualTexture vt, vec2 uv)
+{
+    uv = clamp(uv * vt.uv_scale, 0., 0.99999);
+
+    vec2  dx    = dFdx(uv * vt.virtual_size);
+    vec2  dy    = dFdy(uv * vt.virtual_size);
+    float level = floor(clamp(0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)), 0., vt.max_level));
+
+    vec2  level_size = max(floor(vt.virtual_size / exp2(level)), vec2(1.));
+    uvec4 entry      = texelFetch(vt.page_table, ivec2(uv * level_size / vt.page_size), int(level));
+
+    // The page we asked for might not be resident yet, in which case the page table points to one of its parents
+    vec2 resident_level_size = max(floor(vt.virtual_size / exp2(float(entry.z))), vec2(1.));
+    vec2 texel               = uv * resident_level_size;
+    vec2 texel_in_page       = texel - floor(texel / vt.page_size) * vt.page_size;
+    vec2 physical_texel      = vec2(entry.xy) * (vt.page_size + 2. * vt.border) + vt.border + texel_in_page;
+    return texture(vt.physical_texture, physical_texel / vt.physical_size);
+}
+
+void main()
+{
+    vec4 texture_color = sample_virtual_texture(my_texture, uv);
+    out_color          = texture_color * (max(dot(normal, light_direction), 0) + 0.3);
+}
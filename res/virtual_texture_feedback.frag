@@ -0,0 +1,26 @@
+#version 430
+
+// Writes, for each pixel, the page of the virtual texture that will be needed to render it.
+// See VirtualTexture::render_feedback().
+
+uniform vec2  virtual_size; // Size of the level 0, in texels
+uniform vec2  uv_scale;
+uniform float page_size;
+uniform float max_level;
+uniform float mip_bias;
+
+in vec2 uv;
+
+layout(location = 0) out uvec4 out_page; // (page x, page y, level, 1)
+
+void main()
+{
+    vec2  texel = uv * uv_scale * virtual_size;
+    vec2  dx    = dFdx(texel);
+    vec2  dy    = dFdy(texel);
+    float level = floor(clamp(0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + mip_bias, 0., max_level));
+
+    vec2 level_size = max(floor(virtual_size / exp2(level)), vec2(1.));
+    vec2 page       = floor(clamp(uv * uv_scale, 0., 0.99999) * level_size / page_size);
+    out_page        = uvec4(uvec2(page), uint(level), 1u);
+}
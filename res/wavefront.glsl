@@ -0,0 +1,46 @@
+// The state shared by the stages of the WavefrontPathTracer: each stage is a separate compute shader,
+// that reads the paths from a queue and writes them into the queue of the next stage.
+#include "path_tracing.glsl"
+
+#define WAVEFRONT_GROUP_SIZE 64u
+
+struct Path {
+    vec4 origin;     // xyz, and LAST_BSDF_PDF in w
+    vec4 direction;  // xyz
+    vec4 throughput; // rgb: the fraction of the light found at the end of the path that reaches the camera
+    uint pixel;      // Index of the pixel, row by row
+    uint sampleIndex;
+    uint dimension;  // The next dimension of the sampler to use
+    uint bounce;
+};
+
+layout(std430) buffer Paths {
+    Path paths[]; // One per pixel
+};
+layout(std430) buffer Hits {
+    Ray hits[]; // What the current ray of each path has hit, written by the intersect stage
+};
+layout(std430) buffer Radiance {
+    vec4 radiance[]; // The sum of the samples of the current frame, per pixel
+};
+
+// The queues. Each one only contains the indices of its paths, so that each stage only runs for the paths that need it.
+#define ACTIVE_QUEUE 0      // The paths that need to be intersected
+#define NEXT_ACTIVE_QUEUE 1 // The paths that need to be intersected at the next bounce
+#define REFRACTIVE_QUEUE 2  // The paths that hit a refractive object
+#define SURFACE_QUEUE 3     // The paths that hit a diffuse / specular object
+layout(std430) buffer QueueCounts {
+    uint queueCounts[4];
+};
+layout(std430) buffer DispatchArgs {
+    uvec4 dispatchArgs[4]; // The work groups count of the stage that reads each queue, for ComputeShader::dispatch_indirect(). w is padding.
+};
+
+uvec4 groupsCountFor(uint pathsCount) {
+    return uvec4((pathsCount + WAVEFRONT_GROUP_SIZE - 1u) / WAVEFRONT_GROUP_SIZE, 1u, 1u, 0u);
+}
+
+// Adds light to the pixel of path
+void addLight(Path path, vec3 col) {
+    radiance[path.pixel] += vec4(col, 0.0); // Each pixel has a single path at a time, no need for an atomic
+}
@@ -0,0 +1,118 @@
+#include "AdaptiveSampler.hpp"
+#include <cassert>
+#include <string>
+#include "PostProcessGraph.hpp"
+
+static constexpr int tile_size{16};
+
+AdaptiveSampler::AdaptiveSampler(AdaptiveSampler_Descriptor const& desc)
+    : _desc{desc}
+    , _scheduler{ComputeShader::create_async({
+          .compute = ShaderSource::File{"res/adaptive_sampling.comp"},
+          .defines = {{"TILE_SIZE", std::to_string(tile_size)}},
+      })}
+{
+    assert(desc.min_samples_count >= 1.f && "The tile mask is only valid once each pixel has been rendered at least once.");
+}
+
+auto AdaptiveSampler::tiles_count() const -> glm::ivec2
+{
+    return (_size + tile_size - 1) / tile_size;
+}
+
+void AdaptiveSampler::render(glm::ivec2 size, Shader const& path_tracer, std::function<void()> const& set_uniforms)
+{
+    if (size != _size || !_accumulation[0])
+    {
+        _size = size;
+        for (auto& accumulation : _accumulation)
+        {
+            accumulation.emplace(RenderTarget_Descriptor{
+                .width          = size.x,
+                .height         = size.y,
+                .color_textures = {
+                    ColorAttachment_Descriptor{.format = InternalFormat_Color::RGBA32F}, // The mean, and the samples count in the alpha
+                    ColorAttachment_Descriptor{.format = InternalFormat_Color::RGBA16F}, // The bright pixels
+                    ColorAttachment_Descriptor{.format = InternalFormat_Color::R32F},    // The second moment
+                },
+            });
+        }
+        _tile_mask.emplace(TextureSource::EmptyImage{.width = tiles_count().x, .height = tiles_count().y, .texture_format = InternalFormatSized::R8});
+        reset();
+    }
+    if (_is_converged)
+        return;
+
+    auto const& previous = *_accumulation[_current];
+    _current             = 1 - _current;
+    _accumulation[_current]->render([&]() {
+        path_tracer.bind();
+        set_uniforms();
+        path_tracer.set_uniform("accumulation", previous.color_texture(0));
+        path_tracer.set_uniform("secondMoment", previous.color_texture(2));
+        path_tracer.set_uniform("tileMask", *_tile_mask);
+        path_tracer.set_uniform("adaptiveTileSize", tile_size);
+        path_tracer.set_uniform("minSamplesCount", _desc.min_samples_count);
+        draw_fullscreen_triangle();
+    });
+    update_tile_mask();
+}
+
+void AdaptiveSampler::update_tile_mask()
+{
+    auto const check_convergence = ++_frames_since_check >= _desc.convergence_check_interval;
+    if (check_convergence)
+    {
+        GLuint const zero{0};
+        _active_tiles_count.upload(std::span{&zero, 1});
+    }
+
+    _scheduler.bind();
+    _scheduler.set_uniform("accumulation", _accumulation[_current]->color_texture(0));
+    _scheduler.set_uniform("secondMoment", _accumulation[_current]->color_texture(2));
+    _scheduler.set_uniform("noiseThreshold", _desc.noise_threshold);
+    _scheduler.set_uniform("minSamplesCount", _desc.min_samples_count);
+    _scheduler.set_image("tileMask", *_tile_mask, InternalFormatSized::R8, ImageAccess::WriteOnly);
+    _scheduler.set_storage_buffer("ActiveTiles", _active_tiles_count);
+    _scheduler.dispatch({tiles_count(), 1});
+    memory_barrier(Barrier::TextureFetch | Barrier::BufferUpdate);
+
+    if (check_convergence)
+    {
+        _frames_since_check = 0;
+        GLuint active_tiles{};
+        _active_tiles_count.download(std::span{&active_tiles, 1});
+        _active_tiles_ratio = static_cast<float>(active_tiles) / static_cast<float>(tiles_count().x * tiles_count().y);
+        _is_converged       = active_tiles == 0;
+    }
+}
+
+auto AdaptiveSampler::texture() const -> Texture const&
+{
+    assert(_accumulation[_current].has_value() && "You must call render() first.");
+    return _accumulation[_current]->color_texture(0);
+}
+
+auto AdaptiveSampler::bright_pixels() const -> Texture const&
+{
+    assert(_accumulation[_current].has_value() && "You must call render() first.");
+    return _accumulation[_current]->color_texture(1);
+}
+
+void AdaptiveSampler::reset()
+{
+    // The mean and the second moment are weighted by the samples count, which is in the alpha: clearing it is enough to start over
+    for (auto& accumulation : _accumulation)
+    {
+        if (accumulation)
+        {
+            accumulation->render([]() {
+                glClearColor(0.f, 0.f, 0.f, 0.f);
+                glClear(GL_COLOR_BUFFER_BIT);
+            });
+        }
+    }
+    _frames_since_check = 0;
+    _is_converged       = false;
+    _active_tiles_ratio = 1.f;
+}
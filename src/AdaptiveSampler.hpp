@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <optional>
+#include "ComputeShader.hpp"
+#include "RenderTarget.hpp"
+#include "StorageBuffer.hpp"
+#include "Texture.hpp"
+#include "glm/glm.hpp"
+
+struct AdaptiveSampler_Descriptor {
+    float noise_threshold{0.02f};        // A pixel has converged once the standard error of its mean is below this fraction of its luminance
+    float min_samples_count{8.f};        // The variance isn't reliable with few samples, so every pixel gets at least this many frames of samples
+    int   convergence_check_interval{8}; // Reading back the number of tiles that still need samples stalls the GPU, so we only do it every few frames
+};
+
+/// Progressive rendering that spends the samples where the noise is.
+/// Along with the mean of the samples of each pixel, we accumulate the mean of their squared luminance, which gives their variance.
+/// After each frame a compute shader marks the tiles of 16x16 pixels whose error is still above the threshold, and the next frame only traces rays for them (the others just copy their previous value).
+/// Rendering stops once all the tiles have converged.
+class AdaptiveSampler {
+public:
+    explicit AdaptiveSampler(AdaptiveSampler_Descriptor const& = {});
+
+    /// Adds one frame of samples to the pixels that haven't converged yet. Does nothing once the whole image has converged.
+    /// path_tracer must be "res/default.frag", created with the ADAPTIVE_SAMPLING define. It is bound, and then set_uniforms is called to let you set the uniforms of the scene.
+    /// The accumulation is cleared if the size changes.
+    void render(glm::ivec2 size, Shader const& path_tracer, std::function<void()> const& set_uniforms);
+
+    /// The mean of the samples of each pixel. Its alpha is the number of frames of samples that the pixel has received.
+    auto texture() const -> Texture const&;
+    /// The BloomColor output of default.frag
+    auto bright_pixels() const -> Texture const&;
+
+    auto is_converged() const -> bool { return _is_converged; }
+    /// The fraction of the image that was still being refined, the last time we checked.
+    auto active_tiles_ratio() const -> float { return _active_tiles_ratio; }
+
+    /// Forgets all the samples, e.g. because the camera or the scene has changed.
+    void reset();
+
+private:
+    auto tiles_count() const -> glm::ivec2;
+    void update_tile_mask();
+
+private:
+    AdaptiveSampler_Descriptor                 _desc;
+    ComputeShader                              _scheduler;
+    std::array<std::optional<RenderTarget>, 2> _accumulation{}; // We read from one while writing into the other
+    size_t                                     _current{0};     // Index of the one that contains the latest result
+    std::optional<Texture>                     _tile_mask{};
+    StorageBuffer                              _active_tiles_count{sizeof(GLuint)};
+    glm::ivec2                                 _size{0};
+    int                                        _frames_since_check{0};
+    bool                                       _is_converged{false};
+    float                                      _active_tiles_ratio{1.f};
+};
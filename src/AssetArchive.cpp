@@ -0,0 +1,223 @@
+#include "AssetArchive.hpp"
+#include <bit>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <exe_path/exe_path.h>
+#include "fnv1a.hpp"
+#include "handle_error.hpp"
+#include "lz4.hpp"
+#include "make_absolute_path.hpp"
+
+static constexpr size_t data_alignment{64};
+
+/// The key used to look an asset up. It doesn't depend on the platform's path separator, nor on things like "res/../res/".
+static auto asset_key(std::filesystem::path const& asset_path) -> std::string
+{
+    return asset_path.lexically_normal().generic_string();
+}
+
+static auto read_bucket(std::span<std::byte const> buckets, size_t index) -> uint32_t
+{
+    uint32_t value; // NOLINT(*init-variables)
+    std::memcpy(&value, buckets.data() + index * sizeof(uint32_t), sizeof(uint32_t));
+    return value;
+}
+
+AssetArchive::AssetArchive(std::filesystem::path const& archive_path)
+    : _file{make_absolute_path(archive_path)}
+{
+    auto const bytes   = _file.bytes();
+    auto const invalid = [&](std::string_view reason) {
+        handle_error(std::format("\"{}\" is not a valid asset archive: {}", archive_path.string(), reason));
+    };
+
+    if (bytes.size() < sizeof(_header))
+        invalid("the file is too small");
+    std::memcpy(&_header, bytes.data(), sizeof(_header));
+    if (_header.magic != internal::AssetArchiveHeader{}.magic)
+        invalid("wrong magic number");
+    if (_header.version != internal::AssetArchiveHeader{}.version)
+        invalid(std::format("unsupported version {}", _header.version));
+    if (!std::has_single_bit(_header.buckets_count) || _header.buckets_count <= _header.entries_count)
+        invalid("corrupted hash table");
+
+    auto const section = [&](uint64_t offset, uint64_t size) {
+        if (offset > bytes.size() || size > bytes.size() - offset)
+            invalid("a section goes past the end of the file");
+        return bytes.subspan(offset, size);
+    };
+    auto const entries = section(_header.entries_offset, _header.entries_count * sizeof(internal::AssetArchiveEntry));
+    _buckets           = section(_header.buckets_offset, _header.buckets_count * sizeof(uint32_t));
+    _paths             = section(_header.paths_offset, bytes.size() - std::min<uint64_t>(_header.paths_offset, bytes.size()));
+
+    // Copied out of the mapping because the entries are read at each lookup, and this guarantees their alignment
+    _entries.resize(_header.entries_count);
+    std::memcpy(_entries.data(), entries.data(), entries.size());
+    for (auto const& entry : _entries)
+    {
+        section(entry.data_offset, entry.stored_size);
+        if (entry.path_offset > _paths.size() || entry.path_size > _paths.size() - entry.path_offset)
+            invalid("a path goes past the end of the file");
+        if (entry.compression == internal::AssetCompression::None && entry.stored_size != entry.original_size)
+            invalid("an uncompressed asset has the wrong size");
+    }
+}
+
+auto AssetArchive::path_of(internal::AssetArchiveEntry const& entry) const -> std::string_view
+{
+    return {reinterpret_cast<char const*>(_paths.data() + entry.path_offset), entry.path_size}; // NOLINT(*reinterpret-cast)
+}
+
+auto AssetArchive::find(std::filesystem::path const& asset_path) const -> internal::AssetArchiveEntry const*
+{
+    auto const key  = asset_key(asset_path);
+    auto const h    = fnv1a(key);
+    auto const mask = _header.buckets_count - 1;
+    // Linear probing. There is always at least one empty bucket, so this terminates.
+    for (auto bucket = h & mask;; bucket = (bucket + 1) & mask)
+    {
+        auto const entry_index = read_bucket(_buckets, bucket);
+        if (entry_index == 0 || entry_index > _entries.size())
+            return nullptr;
+        auto const& entry = _entries[entry_index - 1];
+        if (entry.path_hash == h && path_of(entry) == key)
+            return &entry;
+    }
+}
+
+auto AssetArchive::read(std::filesystem::path const& asset_path) const -> std::optional<AssetData>
+{
+    auto const* entry = find(asset_path);
+    if (!entry)
+        return std::nullopt;
+    auto const stored = _file.bytes().subspan(entry->data_offset, entry->stored_size);
+    switch (entry->compression)
+    {
+    case internal::AssetCompression::None:
+        return AssetData{stored};
+    case internal::AssetCompression::LZ4:
+        return AssetData{lz4_decompress(stored, entry->original_size)};
+    }
+    handle_error(std::format("Asset \"{}\" uses an unknown compression ({}).", asset_key(asset_path), static_cast<uint32_t>(entry->compression)));
+    return std::nullopt;
+}
+
+static auto read_file(std::filesystem::path const& path) -> std::vector<std::byte>
+{
+    auto ifs = std::ifstream{make_absolute_path(path), std::ios::binary};
+    ifs.seekg(0, std::ios::end);
+    auto data = std::vector<std::byte>(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())); // NOLINT(*reinterpret-cast)
+    if (!ifs)
+        handle_error(std::format("Failed to read \"{}\".", path.string()));
+    return data;
+}
+
+static void pad_to_alignment(std::vector<std::byte>& out, size_t alignment)
+{
+    out.resize((out.size() + alignment - 1) / alignment * alignment);
+}
+
+template<typename T>
+static void append(std::vector<std::byte>& out, T const& value)
+{
+    auto const* bytes = reinterpret_cast<std::byte const*>(&value); // NOLINT(*reinterpret-cast)
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void write_asset_archive(std::filesystem::path const& archive_path, std::filesystem::path const& root_folder, std::span<std::filesystem::path const> asset_paths, bool compress)
+{
+    auto header          = internal::AssetArchiveHeader{};
+    header.entries_count = asset_paths.size();
+    header.buckets_count = std::bit_ceil(std::max<uint64_t>(asset_paths.size() * 2, 2)); // Load factor of at most 50%, so that lookups rarely probe more than one bucket
+
+    auto entries = std::vector<internal::AssetArchiveEntry>(asset_paths.size());
+    auto buckets = std::vector<uint32_t>(header.buckets_count, 0);
+    auto paths   = std::string{};
+    for (size_t i = 0; i < asset_paths.size(); ++i)
+    {
+        auto const key = asset_key(asset_paths[i]);
+        auto&      entry = entries[i];
+        entry.path_hash   = fnv1a(key);
+        entry.path_offset = paths.size();
+        entry.path_size   = key.size();
+        paths += key;
+
+        auto const mask   = header.buckets_count - 1;
+        auto       bucket = entry.path_hash & mask;
+        for (; buckets[bucket] != 0; bucket = (bucket + 1) & mask)
+        {
+            auto const& other = entries[buckets[bucket] - 1];
+            if (other.path_hash == entry.path_hash && std::string_view{paths}.substr(other.path_offset, other.path_size) == key)
+                handle_error(std::format("Asset \"{}\" is listed twice.", key));
+        }
+        buckets[bucket] = static_cast<uint32_t>(i + 1);
+    }
+
+    auto out              = std::vector<std::byte>{};
+    header.entries_offset = sizeof(header);
+    header.buckets_offset = header.entries_offset + entries.size() * sizeof(internal::AssetArchiveEntry);
+    header.paths_offset   = header.buckets_offset + buckets.size() * sizeof(uint32_t);
+    out.resize(header.paths_offset); // The header, entries and buckets are written at the end, once the data offsets are known
+    for (char const c : paths)
+        out.push_back(static_cast<std::byte>(c));
+
+    for (size_t i = 0; i < asset_paths.size(); ++i)
+    {
+        auto const data = read_file(root_folder / asset_paths[i]);
+        auto&      entry = entries[i];
+        entry.original_size = data.size();
+        entry.compression   = internal::AssetCompression::None;
+        auto compressed     = compress ? lz4_compress(data) : std::vector<std::byte>{};
+        auto const& stored  = compress && compressed.size() < data.size() ? compressed : data;
+        if (&stored == &compressed)
+            entry.compression = internal::AssetCompression::LZ4;
+
+        pad_to_alignment(out, data_alignment);
+        entry.data_offset = out.size();
+        entry.stored_size = stored.size();
+        out.insert(out.end(), stored.begin(), stored.end());
+    }
+
+    auto tables = std::vector<std::byte>{};
+    append(tables, header);
+    for (auto const& entry : entries)
+        append(tables, entry);
+    for (auto const bucket : buckets)
+        append(tables, bucket);
+    std::copy(tables.begin(), tables.end(), out.begin());
+
+    auto ofs = std::ofstream{archive_path, std::ios::binary};
+    ofs.write(reinterpret_cast<char const*>(out.data()), static_cast<std::streamsize>(out.size())); // NOLINT(*reinterpret-cast)
+    if (!ofs)
+        handle_error(std::format("Failed to write asset archive \"{}\".", archive_path.string()));
+}
+
+static auto default_archive() -> AssetArchive const*
+{
+    static auto const archive = []() -> std::unique_ptr<AssetArchive> {
+        auto const path = exe_path::dir() / "assets.pak";
+        if (!std::filesystem::exists(path))
+            return nullptr;
+        return std::make_unique<AssetArchive>(path);
+    }();
+    return archive.get();
+}
+
+auto read_asset(std::filesystem::path const& asset_path) -> AssetData
+{
+    if (auto const* archive = default_archive(); archive && asset_path.is_relative())
+    {
+        if (auto data = archive->read(asset_path))
+            return std::move(*data);
+    }
+    return read_loose_asset(asset_path);
+}
+
+auto read_loose_asset(std::filesystem::path const& asset_path) -> AssetData
+{
+    return AssetData{read_file(asset_path)};
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include <img/img.hpp>
+
+/// The content of an asset.
+/// It points directly into the memory-mapped archive when the asset is stored uncompressed, and owns its bytes otherwise (compressed entries and loose files).
+class AssetData {
+public:
+    explicit AssetData(std::span<std::byte const> bytes)
+        : _bytes{bytes}
+    {}
+    explicit AssetData(std::vector<std::byte> bytes)
+        : _bytes{std::move(bytes)}
+    {}
+
+    auto bytes() const -> std::span<std::byte const>
+    {
+        return std::visit([](auto const& bytes) { return std::span<std::byte const>{bytes}; }, _bytes);
+    }
+    auto as_string_view() const -> std::string_view
+    {
+        auto const data = bytes();
+        return {reinterpret_cast<char const*>(data.data()), data.size()}; // NOLINT(*reinterpret-cast)
+    }
+
+private:
+    std::variant<std::span<std::byte const>, std::vector<std::byte>> _bytes;
+};
+
+namespace internal {
+struct AssetArchiveHeader {
+    std::array<char, 4> magic{'T', 'P', 'A', 'K'};
+    uint32_t            version{1};
+    uint64_t            entries_count{};
+    uint64_t            buckets_count{}; // Always a power of 2
+    uint64_t            entries_offset{};
+    uint64_t            buckets_offset{};
+    uint64_t            paths_offset{};
+};
+
+enum class AssetCompression : uint32_t {
+    None = 0,
+    LZ4  = 1,
+};
+
+struct AssetArchiveEntry {
+    uint64_t         path_hash{};
+    uint64_t         path_offset{}; // Relative to AssetArchiveHeader::paths_offset
+    uint64_t         path_size{};
+    uint64_t         data_offset{}; // Relative to the beginning of the file
+    uint64_t         stored_size{};
+    uint64_t         original_size{};
+    AssetCompression compression{AssetCompression::None};
+    uint32_t         padding{};
+};
+} // namespace internal
+
+/// A single file containing many assets, that is memory-mapped once.
+/// The entries are found through a hash table stored in the file, so looking up an asset costs no system call at all.
+/// Assets are identified by their path relative to the executable's folder, written with forward slashes (e.g. "res/texture.png"), exactly like you write them in the code.
+/// You cannot copy an AssetArchive. But you can move it.
+class AssetArchive {
+public:
+    /// Calls handle_error() if the file doesn't exist or isn't a valid archive.
+    explicit AssetArchive(std::filesystem::path const& archive_path);
+
+    /// Returns std::nullopt if the archive doesn't contain this asset.
+    auto read(std::filesystem::path const& asset_path) const -> std::optional<AssetData>;
+    auto contains(std::filesystem::path const& asset_path) const -> bool { return find(asset_path) != nullptr; }
+
+    auto assets_count() const -> size_t { return _entries.size(); }
+
+private:
+    auto find(std::filesystem::path const& asset_path) const -> internal::AssetArchiveEntry const*;
+    auto path_of(internal::AssetArchiveEntry const&) const -> std::string_view;
+
+private:
+    img::MappedFile                          _file;
+    internal::AssetArchiveHeader             _header{};
+    std::vector<internal::AssetArchiveEntry> _entries{};
+    std::span<std::byte const>               _buckets{}; // uint32_t per bucket: index of the entry + 1, or 0 if the bucket is empty
+    std::span<std::byte const>               _paths{};
+};
+
+/// Packs the given assets into an archive.
+/// This is what the pack_assets tool (tools/pack_assets.cpp) runs when you build the "assets" CMake target.
+/// @param root_folder The folder that asset_paths are relative to (typically the folder of the executable).
+/// @param asset_paths The paths of the assets, as they will be looked up (e.g. "res/texture.png").
+/// @param compress If true, each asset is compressed with LZ4 (unless that doesn't make it smaller).
+void write_asset_archive(std::filesystem::path const& archive_path, std::filesystem::path const& root_folder, std::span<std::filesystem::path const> asset_paths, bool compress = true);
+
+/// Reads an asset from "assets.pak" (next to the executable) if there is one and it contains the asset.
+/// Otherwise reads the loose file, which is convenient during development: you can edit a file without rebuilding the archive.
+/// Calls handle_error() if the asset can't be found.
+auto read_asset(std::filesystem::path const& asset_path) -> AssetData;
+
+/// Reads the loose file, even if "assets.pak" contains the asset. Use it for the files that are watched for hot reload, so that their edits are not hidden by the archive.
+/// Calls handle_error() if the file can't be found.
+auto read_loose_asset(std::filesystem::path const& asset_path) -> AssetData;
@@ -0,0 +1,92 @@
+#include "Bloom.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+static constexpr auto levels_format = InternalFormatSized::RGBA16F;
+
+Bloom::Bloom(Bloom_Descriptor const& desc)
+    : _desc{desc}
+    , _downsample{ComputeShader::create_async({.compute = ShaderSource::File{"res/bloom_downsample.comp"}})}
+    , _blur_horizontal{ComputeShader::create_async({.compute = ShaderSource::File{"res/bloom_blur.comp"}})}
+    , _blur_vertical{ComputeShader::create_async({.compute = ShaderSource::File{"res/bloom_blur.comp"}, .defines = {{"VERTICAL"}}})}
+    , _upsample{ComputeShader::create_async({.compute = ShaderSource::File{"res/bloom_upsample.comp"}})}
+{}
+
+void Bloom::create_textures(glm::ivec2 size)
+{
+    _size = size;
+    // Stops before a level gets smaller than 1 pixel
+    auto const smallest_side = std::max(std::min(size.x, size.y) / 2, 1);
+    _levels_count            = std::clamp(static_cast<GLsizei>(std::bit_width(static_cast<unsigned int>(smallest_side))), GLsizei{1}, _desc.levels_count);
+
+    auto const source = TextureSource::EmptyImage{
+        .width          = std::max(size.x / 2, 1),
+        .height         = std::max(size.y / 2, 1),
+        .texture_format = levels_format,
+        .levels_count   = _levels_count,
+    };
+    // textureLod() needs a mipmap filter to read any other level than the first one
+    auto const options = TextureOptions{.minification_filter = Filter::LinearMipmapLinear, .magnification_filter = Filter::Linear};
+    _levels.emplace(source, options);
+    _blur_levels.emplace(source, options);
+}
+
+static auto level_size(glm::ivec2 size, GLsizei level) -> glm::uvec3
+{
+    return {std::max((size.x / 2) >> level, 1), std::max((size.y / 2) >> level, 1), 1};
+}
+
+void Bloom::apply(Texture const& bright_pixels, glm::ivec2 size)
+{
+    if (size != _size || !_levels)
+        create_textures(size);
+
+    // Downsample
+    _downsample.bind();
+    for (GLsizei level = 0; level < _levels_count; ++level)
+    {
+        if (level == 0)
+            _downsample.set_uniform("source", bright_pixels);
+        else
+            _downsample.set_uniform("source", *_levels);
+        _downsample.set_uniform("source_level", level == 0 ? 0 : level - 1);
+        _downsample.set_image("destination", *_levels, levels_format, ImageAccess::WriteOnly, level);
+        _downsample.dispatch_for_size(level_size(size, level));
+        memory_barrier(Barrier::TextureFetch);
+    }
+
+    // Blur each level
+    for (GLsizei level = 0; level < _levels_count; ++level)
+    {
+        _blur_horizontal.bind();
+        _blur_horizontal.set_image("source", *_levels, levels_format, ImageAccess::ReadOnly, level);
+        _blur_horizontal.set_image("destination", *_blur_levels, levels_format, ImageAccess::WriteOnly, level);
+        _blur_horizontal.dispatch_for_size(level_size(size, level));
+        memory_barrier(Barrier::ShaderImageAccess);
+
+        _blur_vertical.bind();
+        _blur_vertical.set_image("source", *_blur_levels, levels_format, ImageAccess::ReadOnly, level);
+        _blur_vertical.set_image("destination", *_levels, levels_format, ImageAccess::WriteOnly, level);
+        _blur_vertical.dispatch_for_size(level_size(size, level));
+    }
+    memory_barrier(Barrier::ShaderImageAccess | Barrier::TextureFetch);
+
+    // Upsample and accumulate, from the smallest level to the biggest
+    _upsample.bind();
+    _upsample.set_uniform("source", *_levels);
+    for (GLsizei level = _levels_count - 2; level >= 0; --level)
+    {
+        _upsample.set_uniform("source_level", level + 1);
+        _upsample.set_uniform("scale", level == 0 ? 1.f / static_cast<float>(_levels_count) : 1.f);
+        _upsample.set_image("destination", *_levels, levels_format, ImageAccess::ReadWrite, level);
+        _upsample.dispatch_for_size(level_size(size, level));
+        memory_barrier(Barrier::ShaderImageAccess | Barrier::TextureFetch);
+    }
+}
+
+auto Bloom::texture() const -> Texture const&
+{
+    assert(_levels.has_value() && "You must call apply() before using the texture of the Bloom.");
+    return *_levels;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <optional>
+#include "ComputeShader.hpp"
+#include "Texture.hpp"
+#include "glm/glm.hpp"
+
+struct Bloom_Descriptor {
+    GLsizei levels_count{6}; // Number of levels of the chain. The first one is half the resolution of the input, and each one is half the resolution of the previous one. More levels give a wider glow.
+};
+
+/// Blurs the bright pixels of an image, at several scales, to make them glow.
+/// Runs a downsample -> blur -> upsample chain (like the one of Call of Duty: Advanced Warfare) with compute shaders:
+/// each pass only processes one level of the chain, so the total cost is about 1.33x the cost of blurring the first level, whatever the number of levels.
+/// Typically you apply() it to the BloomColor output of the path tracer, and give texture() to "res/postProcess.frag" as its bloomTex input.
+class Bloom {
+public:
+    explicit Bloom(Bloom_Descriptor const& = {});
+
+    /// Computes the bloom of bright_pixels, which should contain only the pixels that must glow (the others being black).
+    /// The textures are (re)allocated if the size of the input changes.
+    void apply(Texture const& bright_pixels, glm::ivec2 size);
+
+    /// The result of the last apply(). It is half the resolution of the input: sample it with bilinear filtering.
+    auto texture() const -> Texture const&;
+
+private:
+    void create_textures(glm::ivec2 size);
+
+private:
+    Bloom_Descriptor       _desc;
+    ComputeShader          _downsample;
+    ComputeShader          _blur_horizontal;
+    ComputeShader          _blur_vertical;
+    ComputeShader          _upsample;
+    std::optional<Texture> _levels{};     // All the levels of the chain, in the mipmaps of a single texture
+    std::optional<Texture> _blur_levels{}; // Holds the result of the horizontal blur, before the vertical blur
+    glm::ivec2             _size{0};
+    GLsizei                _levels_count{0};
+};
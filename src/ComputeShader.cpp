@@ -0,0 +1,58 @@
+#include "ComputeShader.hpp"
+#include <array>
+#include <cassert>
+
+ComputeShader::ComputeShader(ComputeShader_Descriptor const& desc)
+    : ComputeShader{desc, true}
+{}
+
+auto ComputeShader::create_async(ComputeShader_Descriptor const& desc) -> ComputeShader
+{
+    return ComputeShader{desc, false};
+}
+
+ComputeShader::ComputeShader(ComputeShader_Descriptor const& desc, bool wait_until_ready)
+    : Shader{{{GL_COMPUTE_SHADER, desc.compute}}, desc.defines, desc.hot_reload, wait_until_ready}
+{}
+
+auto ComputeShader::work_group_size() const -> glm::uvec3
+{
+    wait_until_ready();
+    auto size = std::array<GLint, 3>{};
+    glGetProgramiv(id(), GL_COMPUTE_WORK_GROUP_SIZE, size.data());
+    return {static_cast<GLuint>(size[0]), static_cast<GLuint>(size[1]), static_cast<GLuint>(size[2])};
+}
+
+static void assert_is_bound([[maybe_unused]] GLuint id)
+{
+#ifndef NDEBUG
+    GLint current_id;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_id);
+    assert(static_cast<GLuint>(current_id) == id && "You must call compute_shader.bind() before dispatching it.");
+#endif
+}
+
+void ComputeShader::dispatch(glm::uvec3 groups_count) const
+{
+    assert_is_bound(id());
+    glDispatchCompute(groups_count.x, groups_count.y, groups_count.z);
+}
+
+void ComputeShader::dispatch_for_size(glm::uvec3 size) const
+{
+    auto const group_size = work_group_size();
+    dispatch((size + group_size - 1u) / group_size);
+}
+
+void ComputeShader::dispatch_indirect(StorageBuffer const& arguments, size_t offset_in_bytes) const
+{
+    assert_is_bound(id());
+    assert(offset_in_bytes % 4 == 0 && offset_in_bytes + 3 * sizeof(GLuint) <= arguments.size_in_bytes());
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, arguments.id());
+    glDispatchComputeIndirect(static_cast<GLintptr>(offset_in_bytes));
+}
+
+void memory_barrier(Barrier barriers)
+{
+    glMemoryBarrier(static_cast<GLbitfield>(barriers));
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include "Shader.hpp"
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+
+/// The sources can #include other files, see preprocess_shader().
+struct ComputeShader_Descriptor {
+    AnyShaderSource           compute{};
+    std::vector<ShaderDefine> defines{};
+    bool                      hot_reload{false}; // See Shader_Descriptor::hot_reload
+};
+
+/// A shader that runs on its own, outside of the rasterization pipeline.
+/// Everything that works on a Shader works on a ComputeShader (set_uniform(), set_image(), set_storage_buffer(), async creation, hot reload, etc.).
+/// You cannot copy a ComputeShader. But you can move it.
+class ComputeShader : public Shader {
+public:
+    explicit ComputeShader(ComputeShader_Descriptor const&);
+    /// See Shader::create_async()
+    static auto create_async(ComputeShader_Descriptor const&) -> ComputeShader;
+
+    /// The local_size declared in the shader. Waits until the shader is ready.
+    auto work_group_size() const -> glm::uvec3;
+
+    /// Runs groups_count.x * groups_count.y * groups_count.z work groups.
+    /// You must bind() the shader and set its uniforms first.
+    void dispatch(glm::uvec3 groups_count) const;
+    /// Runs enough work groups to have (at least) one invocation per element of a grid of the given size (e.g. one per pixel of an image). The shader must ignore the invocations that are out of the grid.
+    /// You must bind() the shader and set its uniforms first.
+    void dispatch_for_size(glm::uvec3 size) const;
+    /// Runs the number of work groups stored in arguments at offset_in_bytes (3 GLuints: x, y and z), e.g. written by a previous shader, without reading it back on the CPU.
+    /// You must bind() the shader and set its uniforms first, and call memory_barrier(Barrier::Command) after the shader that wrote the arguments.
+    void dispatch_indirect(StorageBuffer const& arguments, size_t offset_in_bytes = 0) const;
+
+private:
+    ComputeShader(ComputeShader_Descriptor const&, bool wait_until_ready);
+};
+
+enum class Barrier : GLbitfield {
+    VertexAttribArray  = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT,
+    ElementArray       = GL_ELEMENT_ARRAY_BARRIER_BIT,
+    Uniform            = GL_UNIFORM_BARRIER_BIT,
+    TextureFetch       = GL_TEXTURE_FETCH_BARRIER_BIT, // Sample with texture() what a shader wrote with imageStore()
+    ShaderImageAccess  = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT, // imageLoad() what a shader wrote with imageStore()
+    Command            = GL_COMMAND_BARRIER_BIT,
+    PixelBuffer        = GL_PIXEL_BUFFER_BARRIER_BIT,
+    TextureUpdate      = GL_TEXTURE_UPDATE_BARRIER_BIT, // Read back (glGetTexImage) what a shader wrote
+    BufferUpdate       = GL_BUFFER_UPDATE_BARRIER_BIT,  // Read back (StorageBuffer::download()) what a shader wrote
+    Framebuffer        = GL_FRAMEBUFFER_BARRIER_BIT,    // Render to a texture that a shader wrote
+    TransformFeedback  = GL_TRANSFORM_FEEDBACK_BARRIER_BIT,
+    AtomicCounter      = GL_ATOMIC_COUNTER_BARRIER_BIT,
+    ShaderStorage      = GL_SHADER_STORAGE_BARRIER_BIT, // Read from a StorageBuffer what a shader wrote
+    All                = GL_ALL_BARRIER_BITS,
+};
+
+inline auto operator|(Barrier a, Barrier b) -> Barrier
+{
+    return static_cast<Barrier>(static_cast<GLbitfield>(a) | static_cast<GLbitfield>(b));
+}
+
+/// The writes done with imageStore() or in a StorageBuffer are not visible to the commands that come after, until you call this.
+/// barriers tells how the data is going to be read next, e.g. memory_barrier(Barrier::TextureFetch) if you are going to sample the image you just wrote.
+void memory_barrier(Barrier barriers);
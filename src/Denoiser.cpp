@@ -0,0 +1,137 @@
+#include "Denoiser.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <future>
+
+static constexpr auto textures_format = InternalFormatSized::RGBA16F;
+
+Denoiser::Denoiser(Denoiser_Descriptor const& desc)
+    : _desc{desc}
+    , _atrous{ComputeShader::create_async({.compute = ShaderSource::File{"res/denoise_atrous.comp"}})}
+{
+    assert(desc.iterations_count >= 1);
+}
+
+void Denoiser::apply(Texture const& noisy, Texture const& normal_depth, Texture const& albedo, glm::ivec2 size)
+{
+    if (size != _size || !_ping)
+    {
+        _size        = size;
+        auto const source = TextureSource::EmptyImage{.width = size.x, .height = size.y, .texture_format = textures_format};
+        _ping.emplace(source);
+        _pong.emplace(source);
+    }
+
+    _atrous.bind();
+    _atrous.set_uniform("normalDepth", normal_depth);
+    _atrous.set_uniform("albedo", albedo);
+    _atrous.set_uniform("normalPower", _desc.normal_power);
+    _atrous.set_uniform("depthPhi", _desc.depth_phi);
+    for (int i = 0; i < _desc.iterations_count; ++i)
+    {
+        auto const& source      = i == 0 ? noisy : (i % 2 == 1 ? *_ping : *_pong);
+        auto const& destination = i % 2 == 0 ? *_ping : *_pong;
+        _atrous.set_uniform("source", source);
+        _atrous.set_uniform("stepSize", 1 << i);
+        _atrous.set_uniform("colorPhi", _desc.color_phi * std::pow(0.5f, static_cast<float>(i)));
+        _atrous.set_uniform("demodulate", i == 0);
+        _atrous.set_uniform("remodulate", i == _desc.iterations_count - 1);
+        _atrous.set_image("destination", destination, textures_format, ImageAccess::WriteOnly);
+        _atrous.dispatch_for_size({size, 1});
+        memory_barrier(Barrier::TextureFetch);
+    }
+    _result_is_in_ping = _desc.iterations_count % 2 == 1;
+}
+
+auto Denoiser::texture() const -> Texture const&
+{
+    assert(_ping.has_value() && "You must call apply() first.");
+    return _result_is_in_ping ? *_ping : *_pong;
+}
+
+static constexpr auto kernel = std::array{3.f / 8.f, 1.f / 4.f, 1.f / 16.f};
+
+static auto demodulation(glm::vec4 const& albedo) -> glm::vec3
+{
+    return glm::max(glm::vec3{albedo}, glm::vec3{0.001f});
+}
+
+/// One iteration of the filter, on rows [first_row, end_row). Mirrors "res/denoise_atrous.comp".
+static void atrous_iteration(
+    std::span<glm::vec3 const> source, std::span<glm::vec3> destination, DenoiserImages const& images,
+    int step_size, float color_phi, Denoiser_Descriptor const& desc, int first_row, int end_row
+)
+{
+    auto const size  = images.size;
+    auto const index = [&](int x, int y) {
+        return static_cast<size_t>(y) * static_cast<size_t>(size.x) + static_cast<size_t>(x);
+    };
+    for (int y = first_row; y < end_row; ++y)
+    {
+        for (int x = 0; x < size.x; ++x)
+        {
+            auto const  center_illumination = source[index(x, y)];
+            auto const& center_normal_depth = images.normal_depth[index(x, y)];
+
+            auto  sum         = glm::vec3{0.f};
+            float weights_sum = 0.f;
+            for (int j = -2; j <= 2; ++j)
+            {
+                for (int i = -2; i <= 2; ++i)
+                {
+                    auto const  tap_x            = std::clamp(x + i * step_size, 0, size.x - 1);
+                    auto const  tap_y            = std::clamp(y + j * step_size, 0, size.y - 1);
+                    auto const  tap_illumination = source[index(tap_x, tap_y)];
+                    auto const& tap_normal_depth = images.normal_depth[index(tap_x, tap_y)];
+                    auto const  color_difference = center_illumination - tap_illumination;
+                    auto const  color_weight     = std::exp(-glm::dot(color_difference, color_difference) / color_phi);
+                    auto const  normal_weight    = std::pow(std::max(glm::dot(glm::vec3{center_normal_depth}, glm::vec3{tap_normal_depth}), 0.f), desc.normal_power);
+                    auto const  depth_weight     = std::exp(-std::abs(center_normal_depth.w - tap_normal_depth.w) / (desc.depth_phi * static_cast<float>(step_size) + 0.0001f));
+
+                    auto const weight = kernel[static_cast<size_t>(std::abs(i))] * kernel[static_cast<size_t>(std::abs(j))] * color_weight * normal_weight * depth_weight;
+                    sum += tap_illumination * weight;
+                    weights_sum += weight;
+                }
+            }
+            destination[index(x, y)] = sum / weights_sum;
+        }
+    }
+}
+
+auto denoise_on_cpu(DenoiserImages const& images, Denoiser_Descriptor const& desc, ThreadPool& thread_pool) -> std::vector<glm::vec4>
+{
+    auto const pixels_count = static_cast<size_t>(images.size.x) * static_cast<size_t>(images.size.y);
+    assert(images.noisy.size() == pixels_count && images.normal_depth.size() == pixels_count && images.albedo.size() == pixels_count);
+
+    auto ping = std::vector<glm::vec3>(pixels_count);
+    auto pong = std::vector<glm::vec3>(pixels_count);
+    for (size_t i = 0; i < pixels_count; ++i)
+        ping[i] = glm::vec3{images.noisy[i]} / demodulation(images.albedo[i]);
+
+    // A few more chunks than threads, so that the threads that finish early can pick up the remaining work
+    auto const chunks_count = static_cast<int>(thread_pool.threads_count() * 4);
+    auto const rows_per_chunk = std::max((images.size.y + chunks_count - 1) / chunks_count, 1);
+    for (int iteration = 0; iteration < desc.iterations_count; ++iteration)
+    {
+        auto const step_size = 1 << iteration;
+        auto const color_phi = desc.color_phi * std::pow(0.5f, static_cast<float>(iteration));
+        auto       chunks    = std::vector<std::future<void>>{};
+        for (int first_row = 0; first_row < images.size.y; first_row += rows_per_chunk)
+        {
+            auto const end_row = std::min(first_row + rows_per_chunk, images.size.y);
+            chunks.push_back(thread_pool.submit([&, first_row, end_row]() {
+                atrous_iteration(ping, pong, images, step_size, color_phi, desc, first_row, end_row);
+            }));
+        }
+        for (auto& chunk : chunks) // Each iteration reads the whole result of the previous one
+            chunk.get();
+        std::swap(ping, pong);
+    }
+
+    auto result = std::vector<glm::vec4>(pixels_count);
+    for (size_t i = 0; i < pixels_count; ++i)
+        result[i] = glm::vec4{ping[i] * demodulation(images.albedo[i]), 1.f};
+    return result;
+}
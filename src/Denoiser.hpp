@@ -0,0 +1,50 @@
+#pragma once
+#include <optional>
+#include <span>
+#include <vector>
+#include "ComputeShader.hpp"
+#include "Texture.hpp"
+#include "ThreadPool.hpp"
+#include "glm/glm.hpp"
+
+struct Denoiser_Descriptor {
+    int   iterations_count{5}; // Each iteration doubles the radius of the filter: 5 iterations cover 61x61 pixels
+    float color_phi{1.f};      // How different two illuminations can be and still get blended. It is halved at each iteration, because the image gets less noisy.
+    float normal_power{64.f};  // The bigger, the less surfaces with different orientations get blended
+    float depth_phi{0.1f};     // How far apart (per pixel of distance between them) two surfaces can be and still get blended
+};
+
+/// Removes most of the noise of path-traced images that have very few samples per pixel, so that they are usable after 1 to 4 samples.
+/// It uses an edge-avoiding à-trous wavelet filter, guided by the normal, depth and albedo of the first hit of each pixel:
+/// render "res/default.frag" with the DENOISER_FEATURES define to get them.
+/// The filter runs on the GPU, see denoise_on_cpu() for the CPU version.
+class Denoiser {
+public:
+    explicit Denoiser(Denoiser_Descriptor const& = {});
+
+    /// noisy, normal_depth and albedo are the FragColor, NormalDepth and Albedo outputs of default.frag.
+    /// The textures are (re)allocated if the size changes.
+    void apply(Texture const& noisy, Texture const& normal_depth, Texture const& albedo, glm::ivec2 size);
+
+    /// The result of the last apply()
+    auto texture() const -> Texture const&;
+
+private:
+    Denoiser_Descriptor    _desc;
+    ComputeShader          _atrous;
+    std::optional<Texture> _ping{}; // Each iteration reads from one and writes into the other
+    std::optional<Texture> _pong{};
+    glm::ivec2             _size{0};
+    bool                   _result_is_in_ping{true};
+};
+
+struct DenoiserImages {
+    std::span<glm::vec4 const> noisy{};
+    std::span<glm::vec4 const> normal_depth{};
+    std::span<glm::vec4 const> albedo{};
+    glm::ivec2                 size{};
+};
+
+/// The same filter as Denoiser, on the CPU, for when there is no GPU to run it (e.g. images rendered offline, or read back from the GPU).
+/// The rows of the image are split between the threads of thread_pool. The images are stored row by row, with one glm::vec4 per pixel.
+auto denoise_on_cpu(DenoiserImages const& images, Denoiser_Descriptor const& desc, ThreadPool& thread_pool) -> std::vector<glm::vec4>;
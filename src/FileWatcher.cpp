@@ -0,0 +1,109 @@
+#include "FileWatcher.hpp"
+#include <algorithm>
+#include <array>
+#include <system_error>
+#include <utility>
+#include <exe_path/exe_path.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static auto write_time(std::filesystem::path const& path) -> std::filesystem::file_time_type
+{
+    std::error_code error; // The file might be missing while an editor is saving it
+    auto const      time = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type{} : time;
+}
+
+FileWatcher::FileWatcher()
+{
+#if defined(__linux__)
+    _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC); // If this fails we fall back to comparing the write times
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#if defined(__linux__)
+    if (_inotify != -1)
+        close(_inotify);
+#endif
+}
+
+FileWatcher::FileWatcher(FileWatcher&& o) noexcept
+    : _files{std::move(o._files)}
+    , _inotify{std::exchange(o._inotify, -1)}
+    , _watches{std::move(o._watches)}
+{
+}
+
+auto FileWatcher::operator=(FileWatcher&& o) noexcept -> FileWatcher&
+{
+    if (&o != this)
+    {
+#if defined(__linux__)
+        if (_inotify != -1)
+            close(_inotify);
+#endif
+        _files   = std::move(o._files);
+        _inotify = std::exchange(o._inotify, -1);
+        _watches = std::move(o._watches);
+    }
+    return *this;
+}
+
+void FileWatcher::watch(std::filesystem::path const& file_path)
+{
+    auto const path = (file_path.is_relative() ? exe_path::dir() / file_path : file_path).lexically_normal();
+    if (std::any_of(_files.begin(), _files.end(), [&](WatchedFile const& file) { return file.path == path; }))
+        return;
+    _files.push_back({path, write_time(path)});
+#if defined(__linux__)
+    if (_inotify != -1)
+    {
+        // inotify gives the same watch descriptor if the folder is already watched
+        int const watch = inotify_add_watch(_inotify, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (watch != -1 && std::find(_watches.begin(), _watches.end(), watch) == _watches.end())
+            _watches.push_back(watch);
+    }
+#endif
+}
+
+void FileWatcher::clear()
+{
+#if defined(__linux__)
+    for (int const watch : _watches)
+        inotify_rm_watch(_inotify, watch);
+#endif
+    _watches.clear();
+    _files.clear();
+}
+
+auto FileWatcher::has_changed() -> bool
+{
+    bool changed = false;
+#if defined(__linux__)
+    if (_inotify != -1)
+    {
+        // The events only tell us the name of the file, and the folder might contain other files that we don't watch.
+        // So we use them as a cheap hint, and then check the write times.
+        bool got_events = false;
+        alignas(inotify_event) std::array<char, 4096> buffer{};
+        while (read(_inotify, buffer.data(), buffer.size()) > 0)
+            got_events = true;
+        if (!got_events)
+            return false;
+    }
+#endif
+    for (auto& file : _files)
+    {
+        auto const time = write_time(file.path);
+        if (time != file.last_write_time)
+        {
+            file.last_write_time = time;
+            changed              = true;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+
+/// Tells you when some files have been modified.
+/// On Linux it uses inotify, so checking costs a single non-blocking read. On other platforms it compares the last write time of each file.
+/// The folders are watched rather than the files themselves, so that it keeps working with editors that save by writing a new file and renaming it over the old one.
+/// You cannot copy a FileWatcher. But you can move it.
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(FileWatcher const&)                    = delete;
+    auto operator=(FileWatcher const&) -> FileWatcher& = delete;
+    FileWatcher(FileWatcher&&) noexcept;
+    auto operator=(FileWatcher&&) noexcept -> FileWatcher&;
+
+    /// Relative paths are relative to the folder of the executable, like everywhere else.
+    void watch(std::filesystem::path const& file_path);
+    /// Stops watching all the files.
+    void clear();
+
+    /// Returns true if at least one of the watched files has been modified since the last call. Never blocks.
+    auto has_changed() -> bool;
+
+private:
+    struct WatchedFile {
+        std::filesystem::path           path;
+        std::filesystem::file_time_type last_write_time;
+    };
+    std::vector<WatchedFile> _files{};
+    int                      _inotify{-1};
+    std::vector<int>         _watches{}; // One per folder
+};
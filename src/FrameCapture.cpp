@@ -0,0 +1,174 @@
+#include "FrameCapture.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <img/img.hpp>
+#include "handle_error.hpp"
+
+static auto bytes_per_pixel(ImageFileFormat format) -> size_t
+{
+    return format == ImageFileFormat::EXR ? 4 * sizeof(float) : 4;
+}
+
+FrameCapture::FrameCapture(FrameCapture_Descriptor const& desc)
+    : _readbacks(std::max(desc.ring_size, size_t{1}))
+    , _thread_pool{std::max(desc.encoding_threads_count, size_t{1})}
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+    // We can't throw from a destructor, so we report the failed captures and keep waiting for the other ones
+    while (pending_captures_count() != 0)
+    {
+        try
+        {
+            finish();
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << "Failed to save a capture: " << e.what() << '\n';
+        }
+    }
+}
+
+void FrameCapture::capture(RenderTarget& render_target, std::filesystem::path const& file_path, ImageFileFormat format, size_t color_attachment_index)
+{
+    auto& readback = _readbacks[_next_readback];
+    _next_readback = (_next_readback + 1) % _readbacks.size();
+    if (readback.fence != nullptr) // The ring is full, we have no choice but to wait for the oldest readback
+        finish_readback(readback, true /*wait*/);
+
+    readback.width     = render_target.width();
+    readback.height    = render_target.height();
+    readback.file_path = file_path;
+    readback.format    = format;
+
+    auto const size = static_cast<GLsizeiptr>(readback.width) * readback.height * static_cast<GLsizeiptr>(bytes_per_pixel(format));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixel_buffer.id());
+    if (readback.capacity < size)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        readback.capacity = size;
+    }
+    render_target.render([&]() { // HACK, we reuse render() as a way to have our framebuffer bound
+        glReadBuffer(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + color_attachment_index));
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, readback.width, readback.height, GL_RGBA, format == ImageFileFormat::EXR ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr); // Writes into the bound GL_PIXEL_PACK_BUFFER, so it returns immediately
+    });
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void FrameCapture::update()
+{
+    // Readbacks complete in the order they have been submitted, so we start with the oldest one
+    for (size_t i = 0; i < _readbacks.size(); ++i)
+    {
+        auto& readback = _readbacks[(_next_readback + i) % _readbacks.size()];
+        if (readback.fence != nullptr)
+            finish_readback(readback, false /*wait*/);
+    }
+    remove_finished_encodings();
+}
+
+void FrameCapture::finish()
+{
+    for (size_t i = 0; i < _readbacks.size(); ++i)
+    {
+        auto& readback = _readbacks[(_next_readback + i) % _readbacks.size()];
+        if (readback.fence != nullptr)
+            finish_readback(readback, true /*wait*/);
+    }
+    while (!_encodings.empty())
+    {
+        auto encoding = std::move(_encodings.front());
+        _encodings.erase(_encodings.begin()); // Removed before get(), so that if it throws we don't wait for it again
+        encoding.get();
+    }
+}
+
+auto FrameCapture::pending_captures_count() const -> size_t
+{
+    return _encodings.size() + static_cast<size_t>(std::count_if(_readbacks.begin(), _readbacks.end(), [](Readback const& readback) {
+               return readback.fence != nullptr;
+           }));
+}
+
+void FrameCapture::finish_readback(Readback& readback, bool wait)
+{
+    auto const timeout = wait ? std::chrono::nanoseconds{std::chrono::seconds{1}}.count() : 0;
+    auto       status  = glClientWaitSync(readback.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, static_cast<GLuint64>(timeout));
+    while (wait && status == GL_TIMEOUT_EXPIRED) // The GPU is just slow, keep waiting
+        status = glClientWaitSync(readback.fence, 0, static_cast<GLuint64>(timeout));
+    if (status == GL_TIMEOUT_EXPIRED)
+        return; // Not ready yet
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+    if (status == GL_WAIT_FAILED)
+        handle_error(std::format("Failed to wait for the readback of \"{}\".", readback.file_path.string()));
+
+    auto const width  = static_cast<img::Size::DataType>(readback.width);
+    auto const height = static_cast<img::Size::DataType>(readback.height);
+    auto const size   = static_cast<size_t>(width) * static_cast<size_t>(height) * bytes_per_pixel(readback.format);
+    auto       data   = std::shared_ptr<uint8_t[]>{new uint8_t[size]}; // NOLINT(*avoid-c-arrays)
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixel_buffer.id());
+    if (void const* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT))
+    {
+        std::memcpy(data.get(), mapped, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        handle_error(std::format("Failed to read back the pixels of \"{}\".", readback.file_path.string()));
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Rows read from OpenGL start at the bottom, which is what img expects by default.
+    // Captures are already encoded in parallel with each other, so each one only uses the thread it is running on.
+    _encodings.push_back(_thread_pool.submit([data, width, height, file_path = readback.file_path, format = readback.format]() {
+        switch (format)
+        {
+        case ImageFileFormat::PNG:
+            img::save_png(file_path, width, height, data.get(), 4, true, {.threads_count = 1});
+            break;
+        case ImageFileFormat::JPEG:
+            img::save_jpeg(file_path, width, height, data.get(), 4);
+            break;
+        case ImageFileFormat::EXR:
+            img::save_exr(file_path, width, height, reinterpret_cast<float const*>(data.get()), 4, true, {.threads_count = 1});
+            break;
+        }
+    }));
+}
+
+void FrameCapture::remove_finished_encodings()
+{
+    // The finished encodings are removed before get() is called, so that if one of them throws, the others (and the ones still running) stay valid
+    auto const first_finished = std::stable_partition(_encodings.begin(), _encodings.end(), [](std::future<void> const& encoding) {
+        return encoding.wait_for(std::chrono::seconds{0}) != std::future_status::ready;
+    });
+    auto finished = std::vector<std::future<void>>{std::make_move_iterator(first_finished), std::make_move_iterator(_encodings.end())};
+    _encodings.erase(first_finished, _encodings.end());
+    auto first_error = std::exception_ptr{};
+    for (auto& encoding : finished)
+    {
+        try
+        {
+            encoding.get(); // Rethrows the error if the encoding failed
+        }
+        catch (...)
+        {
+            if (!first_error)
+                first_error = std::current_exception();
+        }
+    }
+    if (first_error)
+        std::rethrow_exception(first_error);
+}
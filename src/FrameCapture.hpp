@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <vector>
+#include "Buffer.hpp"
+#include "RenderTarget.hpp"
+#include "ThreadPool.hpp"
+#include <glad/glad.h>
+
+enum class ImageFileFormat {
+    PNG,
+    JPEG,
+    EXR, /// Keeps the full range of float render targets (e.g. RGBA32F). Saved as 16-bit floats.
+};
+
+struct FrameCapture_Descriptor {
+    size_t ring_size{3};                                                                   /// Number of readbacks that can be in flight at the same time. If you capture more often than the GPU can finish them, capture() will wait for the oldest one.
+    size_t encoding_threads_count{std::max(std::thread::hardware_concurrency(), 2u) - 1}; /// Number of threads used to encode and write the images.
+};
+
+/// Saves the content of RenderTargets to disk without stalling the GPU.
+/// capture() only asks the GPU to copy the pixels into a Pixel Buffer Object. Once the copy is done (which we know thanks to a fence), the pixels are encoded and written on worker threads.
+/// You must call update() regularly (typically once per frame) so that finished readbacks are handed to the workers.
+class FrameCapture {
+public:
+    explicit FrameCapture(FrameCapture_Descriptor const& = {});
+    ~FrameCapture();
+    FrameCapture(FrameCapture const&)                    = delete;
+    auto operator=(FrameCapture const&) -> FrameCapture& = delete;
+    FrameCapture(FrameCapture&&)                         = delete;
+    auto operator=(FrameCapture&&) -> FrameCapture&      = delete;
+
+    /// Starts reading back the given color attachment of render_target. It will be saved to file_path once the GPU is done.
+    void capture(RenderTarget& render_target, std::filesystem::path const& file_path, ImageFileFormat format = ImageFileFormat::PNG, size_t color_attachment_index = 0);
+    /// Hands the readbacks that the GPU has finished to the encoding threads. Never blocks.
+    void update();
+    /// Waits until all the captures have been written to disk.
+    void finish();
+
+    /// Number of captures that have been requested but not written to disk yet.
+    auto pending_captures_count() const -> size_t;
+
+private:
+    struct Readback {
+        internal::UniqueBuffer pixel_buffer{};
+        GLsizeiptr             capacity{0};
+        GLsync                 fence{nullptr};
+        GLsizei                width{};
+        GLsizei                height{};
+        std::filesystem::path  file_path{};
+        ImageFileFormat        format{};
+    };
+
+    /// Copies the pixels out of the buffer and sends them to the encoding threads.
+    void finish_readback(Readback&, bool wait);
+    void remove_finished_encodings();
+
+private:
+    std::vector<Readback>          _readbacks;
+    size_t                         _next_readback{0};
+    std::vector<std::future<void>> _encodings{};
+    ThreadPool                     _thread_pool; // Must be declared last, so that the pending encodings finish before the other members are destroyed
+};
@@ -0,0 +1,221 @@
+#include "GLState.hpp"
+#include <array>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+struct BlendFunc {
+    GLenum src_rgb;
+    GLenum dst_rgb;
+    GLenum src_alpha;
+    GLenum dst_alpha;
+
+    auto operator==(BlendFunc const&) const -> bool = default;
+};
+
+/// std::nullopt means that we don't know the value, because it has never been set through GLState
+struct State {
+    std::optional<GLuint>              draw_framebuffer{};
+    std::optional<GLuint>              read_framebuffer{};
+    std::optional<glm::ivec4>          viewport{};
+    std::optional<GLuint>              program{};
+    std::optional<GLuint>              vertex_array{};
+    std::optional<GLuint>              active_texture_unit{};
+    std::vector<std::optional<GLuint>> textures{}; // Indexed by texture unit
+    std::unordered_map<GLenum, bool>   capabilities{};
+    std::optional<BlendFunc>           blend_func{};
+    std::optional<GLenum>              depth_func{};
+    std::optional<bool>                depth_mask{};
+    GLState::Stats                     stats{};
+};
+} // namespace
+
+static auto state() -> State&
+{
+    static auto instance = State{};
+    return instance;
+}
+
+/// Returns true if OpenGL must be called, and remembers the new value
+template<typename T>
+static auto update(std::optional<T>& current, T const& value) -> bool
+{
+    if (current == value)
+    {
+        state().stats.redundant_calls_count++;
+        return false;
+    }
+    current = value;
+    state().stats.calls_count++;
+    return true;
+}
+
+static auto query_integer(GLenum name) -> GLuint
+{
+    GLint value{};
+    glGetIntegerv(name, &value);
+    state().stats.queries_count++;
+    return static_cast<GLuint>(value);
+}
+
+namespace GLState {
+
+void bind_framebuffer(GLenum target, GLuint framebuffer)
+{
+    auto& s = state();
+    if (target == GL_FRAMEBUFFER)
+    {
+        if (s.draw_framebuffer == framebuffer && s.read_framebuffer == framebuffer)
+        {
+            s.stats.redundant_calls_count++;
+            return;
+        }
+        s.draw_framebuffer = framebuffer;
+        s.read_framebuffer = framebuffer;
+        s.stats.calls_count++;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+    else if (update(target == GL_DRAW_FRAMEBUFFER ? s.draw_framebuffer : s.read_framebuffer, framebuffer))
+    {
+        glBindFramebuffer(target, framebuffer);
+    }
+}
+
+auto draw_framebuffer() -> GLuint
+{
+    auto& s = state();
+    if (!s.draw_framebuffer)
+        s.draw_framebuffer = query_integer(GL_DRAW_FRAMEBUFFER_BINDING);
+    return *s.draw_framebuffer;
+}
+
+auto read_framebuffer() -> GLuint
+{
+    auto& s = state();
+    if (!s.read_framebuffer)
+        s.read_framebuffer = query_integer(GL_READ_FRAMEBUFFER_BINDING);
+    return *s.read_framebuffer;
+}
+
+void set_viewport(glm::ivec4 const& viewport)
+{
+    if (update(state().viewport, viewport))
+        glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+}
+
+auto viewport() -> glm::ivec4
+{
+    auto& s = state();
+    if (!s.viewport)
+    {
+        auto values = std::array<GLint, 4>{};
+        glGetIntegerv(GL_VIEWPORT, values.data());
+        s.stats.queries_count++;
+        s.viewport = glm::ivec4{values[0], values[1], values[2], values[3]};
+    }
+    return *s.viewport;
+}
+
+void use_program(GLuint program)
+{
+    if (update(state().program, program))
+        glUseProgram(program);
+}
+
+void bind_vertex_array(GLuint vertex_array)
+{
+    if (update(state().vertex_array, vertex_array))
+        glBindVertexArray(vertex_array);
+}
+
+void bind_texture(GLuint unit, GLuint texture)
+{
+    auto& s = state();
+    if (s.textures.size() <= unit)
+        s.textures.resize(unit + 1);
+    // Even if the texture is already bound, the unit must become the active one: callers then edit "the bound texture" (glTexSubImage2D, glGetTexImage, etc.), which only refers to the active unit
+    if (update(s.active_texture_unit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    if (update(s.textures[unit], texture))
+        glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void set_enabled(GLenum capability, bool enabled)
+{
+    auto& s  = state();
+    auto  it = s.capabilities.find(capability);
+    if (it != s.capabilities.end() && it->second == enabled)
+    {
+        s.stats.redundant_calls_count++;
+        return;
+    }
+    s.capabilities[capability] = enabled;
+    s.stats.calls_count++;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void set_blend_func(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha)
+{
+    if (update(state().blend_func, BlendFunc{src_rgb, dst_rgb, src_alpha, dst_alpha}))
+        glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+}
+
+void set_depth_func(GLenum func)
+{
+    if (update(state().depth_func, func))
+        glDepthFunc(func);
+}
+
+void set_depth_mask(bool write_depth)
+{
+    if (update(state().depth_mask, write_depth))
+        glDepthMask(write_depth ? GL_TRUE : GL_FALSE);
+}
+
+void forget_framebuffer(GLuint framebuffer)
+{
+    auto& s = state();
+    if (s.draw_framebuffer == framebuffer)
+        s.draw_framebuffer = 0;
+    if (s.read_framebuffer == framebuffer)
+        s.read_framebuffer = 0;
+}
+
+void forget_vertex_array(GLuint vertex_array)
+{
+    auto& s = state();
+    if (s.vertex_array == vertex_array)
+        s.vertex_array = 0;
+}
+
+void forget_texture(GLuint texture)
+{
+    for (auto& bound : state().textures)
+    {
+        if (bound == texture)
+            bound = 0;
+    }
+}
+
+void invalidate()
+{
+    auto const stats = state().stats;
+    state()          = State{};
+    state().stats    = stats;
+}
+
+auto stats() -> Stats const&
+{
+    return state().stats;
+}
+
+void reset_stats()
+{
+    state().stats = {};
+}
+
+} // namespace GLState
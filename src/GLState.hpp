@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+
+/// A CPU-side copy of the OpenGL state that we change the most often.
+/// Going through these functions instead of calling OpenGL directly skips the calls that wouldn't change anything,
+/// and lets us read the current state without glGet*(), which can stall the driver until all the previous commands are processed.
+/// The only glGet*() happens the first time you read a value that has never been set through here (or after invalidate()).
+/// If you change this state with raw OpenGL calls, call invalidate() afterwards (ImGui's backend restores everything it touches, so it doesn't need to).
+namespace GLState {
+
+/// target can be GL_FRAMEBUFFER (both draw and read), GL_DRAW_FRAMEBUFFER or GL_READ_FRAMEBUFFER.
+void bind_framebuffer(GLenum target, GLuint framebuffer);
+auto draw_framebuffer() -> GLuint;
+auto read_framebuffer() -> GLuint;
+
+/// x, y, width, height
+void set_viewport(glm::ivec4 const& viewport);
+auto viewport() -> glm::ivec4;
+
+void use_program(GLuint program);
+void bind_vertex_array(GLuint vertex_array);
+/// Binds a GL_TEXTURE_2D to the given texture unit, and makes that unit the active one (even if the texture was already bound), so that you can then edit the texture.
+void bind_texture(GLuint unit, GLuint texture);
+
+/// capability is the one you would give to glEnable() / glDisable(), e.g. GL_DEPTH_TEST or GL_BLEND.
+void set_enabled(GLenum capability, bool enabled);
+void set_blend_func(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha);
+void set_depth_func(GLenum func);
+void set_depth_mask(bool write_depth);
+
+/// Must be called when an object is deleted, because OpenGL unbinds it, and its id can be reused for a new object.
+/// The Unique* classes do it for you.
+void forget_framebuffer(GLuint framebuffer);
+void forget_vertex_array(GLuint vertex_array);
+void forget_texture(GLuint texture);
+
+/// Forgets everything, so that the next calls go to OpenGL no matter what.
+void invalidate();
+
+struct Stats {
+    uint64_t calls_count{};           // Calls that have been forwarded to OpenGL
+    uint64_t redundant_calls_count{}; // Calls that have been skipped because they wouldn't have changed anything
+    uint64_t queries_count{};         // glGet*() that were needed because the value was unknown
+};
+auto stats() -> Stats const&;
+void reset_stats();
+
+} // namespace GLState
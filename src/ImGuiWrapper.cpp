@@ -64,7 +64,7 @@ void scroll_callback(GLFWwindow*, double x_offset, double y_offset)
 }
 void framebuffer_resized_callback(GLFWwindow*, int width_in_pixels, int height_in_pixels)
 {
-    glViewport(0, 0, width_in_pixels, height_in_pixels);
+    GLState::set_viewport({0, 0, width_in_pixels, height_in_pixels});
     for (auto const& callbacks : context().events_callbacks)
         callbacks.on_framebuffer_resized({.width_in_pixels = width_in_pixels, .height_in_pixels = height_in_pixels});
 }
@@ -238,6 +238,27 @@ auto delta_time_in_seconds() -> float
     return context().delta_time;
 }
 
+void shader_errors_window(std::initializer_list<std::reference_wrapper<Shader const>> shaders)
+{
+    bool window_is_open = false;
+    for (Shader const& shader : shaders)
+    {
+        auto const error = shader.hot_reload_error();
+        if (error.empty())
+            continue;
+        if (!window_is_open)
+        {
+            ImGui::Begin("Shader errors");
+            window_is_open = true;
+        }
+        ImGui::TextColored({1.f, 0.3f, 0.3f, 1.f}, "Shader %u", shader.id());
+        ImGui::TextUnformatted(error.data(), error.data() + error.size());
+        ImGui::Separator();
+    }
+    if (window_is_open)
+        ImGui::End();
+}
+
 static auto default_shader() -> Shader&
 {
     static auto instance = Shader{{
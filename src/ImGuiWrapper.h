@@ -4,14 +4,27 @@
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
+#include <functional>
+#include <initializer_list>
 #include <vector>
 #include <string_view>
+#include "AdaptiveSampler.hpp"
+#include "Bloom.hpp"
 #include "Camera.hpp"
+#include "ComputeShader.hpp"
+#include "Denoiser.hpp"
 #include "EventsCallbacks.hpp"
+#include "GLState.hpp"
+#include "LightSampler.hpp"
+#include "LowDiscrepancySampler.hpp"
 #include "Mesh.hpp"
+#include "PostProcessGraph.hpp"
+#include "RenderGraph.hpp"
 #include "RenderTarget.hpp"
 #include "Shader.hpp"
+#include "TemporalReprojection.hpp"
 #include "Texture.hpp"
+#include "WavefrontPathTracer.hpp"
 #include "make_absolute_path.hpp"
 #include <glad/glad.h>
 #include "glm/glm.hpp"
@@ -38,6 +51,8 @@ auto        time_in_seconds() -> float;
 auto        delta_time_in_seconds() -> float;
 
 void        bind_default_shader();
+/// Shows a window with the errors of the shaders that failed to hot-reload (see Shader_Descriptor::hot_reload). Shows nothing if there are none.
+void        shader_errors_window(std::initializer_list<std::reference_wrapper<Shader const>> shaders);
 auto        sphere_vertices();
 
 } // namespace ImGuiWrapper
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "LightSampler.hpp"
+#include <cassert>
+#include <numbers>
+
+static auto object_power(std::span<float const> object) -> float
+{
+    auto const color     = glm::vec3{object[3], object[4], object[5]} * object[16];
+    auto const luminance = glm::dot(color, glm::vec3{0.2126f, 0.7152f, 0.0722f});
+    auto const type      = object[6];
+    if (type == 1.f) // Sphere
+        return luminance * 4.f * std::numbers::pi_v<float> * object[7] * object[7];
+    if (type == 2.f) // Cube
+        return luminance * 8.f * (object[8] * object[9] + object[9] * object[10] + object[10] * object[8]);
+    return 0.f;
+}
+
+auto build_light_table(std::span<float const> objects) -> std::vector<glm::vec4>
+{
+    assert(objects.size() <= static_cast<size_t>(max_objects * elements_per_object));
+    auto table = std::vector<glm::vec4>(2 * max_objects, glm::vec4{0.f});
+
+    auto lights = std::vector<int>{};
+    auto powers = std::vector<float>{};
+    for (int i = 0; (i + 1) * elements_per_object <= static_cast<int>(objects.size()); ++i)
+    {
+        auto const object = objects.subspan(static_cast<size_t>(i * elements_per_object), elements_per_object);
+        if (object[11] != 1.f) // Not a light
+            continue;
+        auto const power = object_power(object);
+        if (power <= 0.f)
+            continue;
+        lights.push_back(i);
+        powers.push_back(power);
+    }
+    if (lights.empty())
+        return table;
+
+    auto total_power = 0.f;
+    for (auto const power : powers)
+        total_power += power;
+
+    // Vose's alias method: each entry keeps its own light with probability x, and gives the rest of its slot to a light that has more than its share
+    auto const count  = lights.size();
+    auto       scaled = std::vector<float>(count); // The probability of each light, times the number of entries
+    auto       small  = std::vector<size_t>{};
+    auto       large  = std::vector<size_t>{};
+    for (size_t i = 0; i < count; ++i)
+    {
+        scaled[i] = powers[i] / total_power * static_cast<float>(count);
+        (scaled[i] < 1.f ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty())
+    {
+        auto const s = small.back();
+        small.pop_back();
+        auto const l = large.back();
+        table[s].x   = scaled[s];
+        table[s].y   = static_cast<float>(l);
+        scaled[l] -= 1.f - scaled[s];
+        if (scaled[l] < 1.f)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // What remains is only off by rounding errors
+    for (auto const i : small)
+        table[i].x = 1.f;
+    for (auto const i : large)
+        table[i].x = 1.f;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto const pdf = powers[i] / total_power;
+        table[i].z     = static_cast<float>(lights[i]);
+        table[i].w     = pdf;
+        table[static_cast<size_t>(max_objects + lights[i])].x = pdf;
+    }
+    return table;
+}
+
+LightSampler::LightSampler(std::span<float const> objects)
+{
+    update(objects);
+}
+
+void LightSampler::update(std::span<float const> objects)
+{
+    auto const table = build_light_table(objects);
+    _lights_count    = 0;
+    for (int i = 0; i < max_objects; ++i)
+    {
+        if (table[static_cast<size_t>(max_objects + i)].x > 0.f)
+            ++_lights_count;
+    }
+    _table.emplace(
+        TextureSource::Pixels{
+            .pixels               = {reinterpret_cast<uint8_t const*>(table.data()), table.size() * sizeof(glm::vec4)},
+            .width                = max_objects,
+            .height               = 2,
+            .source_pixels_type   = Type::Float,
+            .source_pixels_format = Format::RGBA,
+            .texture_format       = InternalFormat::RGBA32F,
+        },
+        TextureOptions{.minification_filter = Filter::NearestNeighbour, .magnification_filter = Filter::NearestNeighbour}
+    );
+}
+
+void LightSampler::set_uniforms(Shader const& path_tracer) const
+{
+    path_tracer.set_uniform("lightTable", *_table);
+    path_tracer.set_uniform("lightsCount", _lights_count);
+}
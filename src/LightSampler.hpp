@@ -0,0 +1,36 @@
+#pragma once
+#include <optional>
+#include <span>
+#include <vector>
+#include "Shader.hpp"
+#include "Texture.hpp"
+#include "glm/glm.hpp"
+
+/// The layout of the "objects" uniform of "res/path_tracing.glsl". Must match MAX_OBJECTS and ELEMENTS_IN_1OBJ.
+inline constexpr int max_objects{30};
+inline constexpr int elements_per_object{23};
+
+/// The table that next-event estimation uses to pick a light, stored like the lightTable of "res/path_tracing.glsl" (max_objects x 2 texels, row by row).
+/// Row 0 is an alias table (Vose's method), so that a light is picked in constant time with a probability proportional to its power (its emitted color times its area),
+/// and row 1 gives the probability to pick each object.
+/// Only spheres and cubes are used: planes are infinite, they can only be found by the bounces.
+auto build_light_table(std::span<float const> objects) -> std::vector<glm::vec4>;
+
+/// Lets the path tracer send a shadow ray towards a light at each diffuse bounce, instead of only finding the lights when a bounce happens to hit them.
+/// Small lights then converge orders of magnitude faster. Create the path tracer with the NEXT_EVENT_ESTIMATION define to use it.
+class LightSampler {
+public:
+    /// objects is the same array as the "objects" uniform of the path tracer
+    explicit LightSampler(std::span<float const> objects = {});
+
+    /// Call this when the lights have changed
+    void update(std::span<float const> objects);
+    /// Sets the lightTable and lightsCount uniforms. path_tracer must be bound, and created with the NEXT_EVENT_ESTIMATION define.
+    void set_uniforms(Shader const& path_tracer) const;
+
+    auto lights_count() const -> int { return _lights_count; }
+
+private:
+    std::optional<Texture> _table{};
+    int                    _lights_count{0};
+};
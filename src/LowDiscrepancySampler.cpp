@@ -0,0 +1,225 @@
+#include "LowDiscrepancySampler.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+auto sobol_matrices() -> std::array<uint32_t, sobol_dimensions_count * 32> const&
+{
+    static auto const matrices = []() {
+        // Primitive polynomial (degree s, coefficients a) and initial direction numbers m of each dimension, from Joe and Kuo's new-joe-kuo-6.21201 table.
+        // The first dimension is the van der Corput sequence.
+        struct DirectionNumbers {
+            uint32_t              s;
+            uint32_t              a;
+            std::array<uint32_t, 3> m;
+        };
+        static constexpr auto direction_numbers = std::array<DirectionNumbers, sobol_dimensions_count - 1>{{
+            {1, 0, {1, 0, 0}},
+            {2, 1, {1, 3, 0}},
+            {3, 1, {1, 3, 1}},
+        }};
+
+        auto res = std::array<uint32_t, sobol_dimensions_count * 32>{};
+        for (uint32_t bit = 0; bit < 32; ++bit)
+            res[bit] = 1u << (31 - bit);
+        for (uint32_t dimension = 1; dimension < sobol_dimensions_count; ++dimension)
+        {
+            auto const& dn = direction_numbers[dimension - 1];
+            auto* const v  = &res[dimension * 32];
+            for (uint32_t bit = 0; bit < dn.s; ++bit)
+                v[bit] = dn.m[bit] << (31 - bit);
+            for (uint32_t bit = dn.s; bit < 32; ++bit)
+            {
+                v[bit] = v[bit - dn.s] ^ (v[bit - dn.s] >> dn.s);
+                for (uint32_t k = 1; k < dn.s; ++k)
+                    v[bit] ^= ((dn.a >> (dn.s - 1 - k)) & 1u) * v[bit - k];
+            }
+        }
+        return res;
+    }();
+    return matrices;
+}
+
+auto generate_blue_noise(int size, float sigma) -> std::vector<uint16_t>
+{
+    assert(size > 0 && size <= 256 && "The ranks must fit in a uint16_t");
+    auto const pixels_count = static_cast<size_t>(size) * static_cast<size_t>(size);
+
+    // Gaussian energy that each 1 spreads around it, with the distances wrapped around the tile so that it tiles seamlessly
+    auto kernel = std::vector<float>(pixels_count);
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            auto const dx = static_cast<float>(std::min(x, size - x));
+            auto const dy = static_cast<float>(std::min(y, size - y));
+            kernel[static_cast<size_t>(y * size + x)] = std::exp(-(dx * dx + dy * dy) / (2.f * sigma * sigma));
+        }
+    }
+
+    auto is_one = std::vector<bool>(pixels_count, false);
+    auto energy = std::vector<float>(pixels_count, 0.f);
+    auto const set = [&](size_t pixel, bool value) {
+        is_one[pixel]     = value;
+        auto const sign   = value ? 1.f : -1.f;
+        auto const px     = static_cast<int>(pixel) % size;
+        auto const py     = static_cast<int>(pixel) / size;
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+                energy[static_cast<size_t>(y * size + x)] += sign * kernel[static_cast<size_t>(((y - py + size) % size) * size + (x - px + size) % size)];
+        }
+    };
+    auto const tightest_cluster = [&]() { // The 1 that has the most 1s around it
+        size_t res = pixels_count;
+        for (size_t i = 0; i < pixels_count; ++i)
+        {
+            if (is_one[i] && (res == pixels_count || energy[i] > energy[res]))
+                res = i;
+        }
+        return res;
+    };
+    auto const largest_void = [&]() { // The 0 that has the fewest 1s around it
+        size_t res = pixels_count;
+        for (size_t i = 0; i < pixels_count; ++i)
+        {
+            if (!is_one[i] && (res == pixels_count || energy[i] < energy[res]))
+                res = i;
+        }
+        return res;
+    };
+
+    // Initial binary pattern: random 1s, moved from the tightest clusters to the largest voids until they are evenly spread
+    auto order = std::vector<size_t>(pixels_count);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::shuffle(order.begin(), order.end(), std::mt19937{42}); // Fixed seed, so that we get the same noise every time
+    auto const initial_ones_count = std::max(pixels_count / 10, size_t{1});
+    for (size_t i = 0; i < initial_ones_count; ++i)
+        set(order[i], true);
+    while (true)
+    {
+        auto const cluster = tightest_cluster();
+        set(cluster, false);
+        auto const void_ = largest_void();
+        set(void_, true);
+        if (void_ == cluster)
+            break;
+    }
+    auto const initial_is_one  = is_one;
+    auto const initial_energy  = energy;
+
+    auto ranks = std::vector<uint16_t>(pixels_count);
+    // Phase 1: the 1s of the initial pattern get the lowest ranks, by removing the tightest cluster each time
+    for (size_t rank = initial_ones_count; rank-- > 0;)
+    {
+        auto const cluster = tightest_cluster();
+        set(cluster, false);
+        ranks[cluster] = static_cast<uint16_t>(rank);
+    }
+    // Phases 2 and 3: the other pixels, by filling the largest void each time.
+    // Once more than half of the pixels are 1s, Ulichney looks for the tightest cluster of 0s instead, but this is the same pixel,
+    // because the energy of the 0s around a pixel is the sum of the kernel (the same everywhere) minus the energy of the 1s.
+    is_one = initial_is_one;
+    energy = initial_energy;
+    for (size_t rank = initial_ones_count; rank < pixels_count; ++rank)
+    {
+        auto const void_ = largest_void();
+        set(void_, true);
+        ranks[void_] = static_cast<uint16_t>(rank);
+    }
+    return ranks;
+}
+
+LowDiscrepancySampler::LowDiscrepancySampler(LowDiscrepancySampler_Descriptor const& desc)
+    : _blue_noise_size{desc.blue_noise_size}
+    , _blue_noise{generate_blue_noise(desc.blue_noise_size)}
+    , _blue_noise_texture{
+          TextureSource::Pixels{
+              .pixels               = {reinterpret_cast<uint8_t const*>(_blue_noise.data()), _blue_noise.size() * sizeof(uint16_t)},
+              .width                = desc.blue_noise_size,
+              .height               = desc.blue_noise_size,
+              .source_pixels_type   = Type::UnsignedShort,
+              .source_pixels_format = Format::R_Integer,
+              .texture_format       = InternalFormat::R16UI,
+          },
+          {.minification_filter = Filter::NearestNeighbour, .magnification_filter = Filter::NearestNeighbour}, // Integer textures cannot be filtered
+      }
+    , _sobol_matrices_texture{
+          TextureSource::Pixels{
+              .pixels               = {reinterpret_cast<uint8_t const*>(sobol_matrices().data()), sobol_matrices().size() * sizeof(uint32_t)},
+              .width                = 32,
+              .height               = static_cast<GLsizei>(sobol_dimensions_count),
+              .source_pixels_type   = Type::UnsignedInt,
+              .source_pixels_format = Format::R_Integer,
+              .texture_format       = InternalFormat::R32UI,
+          },
+          {.minification_filter = Filter::NearestNeighbour, .magnification_filter = Filter::NearestNeighbour},
+      }
+{
+}
+
+void LowDiscrepancySampler::set_uniforms(Shader const& shader, uint32_t frame_index) const
+{
+    shader.set_uniform("sobolMatrices", _sobol_matrices_texture);
+    shader.set_uniform("blueNoise", _blue_noise_texture);
+    shader.set_uniform("frameIndex", frame_index);
+}
+
+// The functions below must be kept in sync with "res/sampler.glsl"
+
+static auto reverse_bits(uint32_t x) -> uint32_t
+{
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+static auto hash(uint32_t x) -> uint32_t
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+/// Owen scrambling: randomly flips the bits of x, each bit depending on the ones above it. See "Practical Hash-based Owen Scrambling", Burley 2020.
+static auto nested_uniform_scramble(uint32_t x, uint32_t seed) -> uint32_t
+{
+    x = reverse_bits(x);
+    x += seed; // Laine-Karras permutation, that only propagates the changes towards the high bits
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverse_bits(x);
+}
+
+static auto sobol(uint32_t index, uint32_t dimension) -> uint32_t
+{
+    uint32_t res = 0;
+    for (uint32_t bit = 0; index != 0; ++bit, index >>= 1)
+    {
+        if (index & 1u)
+            res ^= sobol_matrices()[dimension * 32 + bit];
+    }
+    return res;
+}
+
+auto LowDiscrepancySampler::sample(glm::ivec2 pixel, uint32_t sample_index, uint32_t dimension) const -> float
+{
+    auto const group          = dimension / sobol_dimensions_count;
+    auto const index          = nested_uniform_scramble(sample_index, hash(group));
+    auto const scrambled      = nested_uniform_scramble(sobol(index, dimension % sobol_dimensions_count), hash(dimension + 0x9e3779b9u));
+    // Each dimension reads the blue noise at a different offset (given by the R2 sequence), otherwise they would all be correlated
+    auto const offset         = glm::ivec2{glm::fract(static_cast<float>(dimension) * glm::vec2{0.7548776662f, 0.5698402910f}) * static_cast<float>(_blue_noise_size)};
+    auto const blue_noise_pos = (pixel + offset) % _blue_noise_size;
+    auto const rank           = _blue_noise[static_cast<size_t>(blue_noise_pos.y * _blue_noise_size + blue_noise_pos.x)];
+    auto const rotation       = (static_cast<float>(rank) + 0.5f) / static_cast<float>(_blue_noise.size());
+    return std::min(glm::fract(static_cast<float>(scrambled) * 0x1p-32f + rotation), 0x1.fffffep-1f);
+}
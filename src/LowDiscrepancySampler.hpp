@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Shader.hpp"
+#include "Texture.hpp"
+#include "glm/glm.hpp"
+
+/// How many dimensions of the Sobol sequence we use. The following dimensions reuse them, with a differently scrambled sample index:
+/// the first dimensions of the Sobol sequence are the well-distributed ones, the other ones only converge with a lot of samples.
+inline constexpr uint32_t sobol_dimensions_count = 4;
+
+/// The generator matrices of the first sobol_dimensions_count dimensions of the Sobol sequence (from Joe and Kuo's direction numbers), one column (a uint32_t) per bit of the sample index.
+auto sobol_matrices() -> std::array<uint32_t, sobol_dimensions_count * 32> const&;
+
+/// The rank (between 0 and size * size - 1) of each pixel of a size x size blue noise tile, generated with Ulichney's void-and-cluster algorithm.
+/// The ranks are stored row by row, and the tile can be repeated without seams. This is slow (O(size^4)), it is meant to be done once at startup.
+auto generate_blue_noise(int size, float sigma = 1.5f) -> std::vector<uint16_t>;
+
+struct LowDiscrepancySampler_Descriptor {
+    int blue_noise_size{64}; // The blue noise tile is repeated across the screen
+};
+
+/// Generates the random numbers of the path tracer: an Owen-scrambled Sobol sequence, which converges much faster than independent random numbers,
+/// rotated by a blue noise in each pixel, so that the remaining error looks like high-frequency noise that the eye (and the Denoiser) barely notices.
+/// The tables are generated on the CPU and uploaded once; "res/sampler.glsl" reads them, and sample() gives the same numbers on the CPU.
+class LowDiscrepancySampler {
+public:
+    explicit LowDiscrepancySampler(LowDiscrepancySampler_Descriptor const& = {});
+
+    /// Binds the tables to shader, which must include "sampler.glsl". frame_index must start at 0 when the accumulation starts over,
+    /// so that the samples of all the frames form a single well-distributed sequence.
+    void set_uniforms(Shader const& shader, uint32_t frame_index) const;
+
+    /// The dimension-th random number of the sample_index-th sample of pixel, in [0, 1). Same as nextSample() in "res/sampler.glsl".
+    auto sample(glm::ivec2 pixel, uint32_t sample_index, uint32_t dimension) const -> float;
+
+private:
+    int                   _blue_noise_size;
+    std::vector<uint16_t> _blue_noise; // The ranks, see generate_blue_noise()
+    Texture               _blue_noise_texture;
+    Texture               _sobol_matrices_texture;
+};
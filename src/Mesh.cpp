@@ -1,6 +1,7 @@
 #include "Mesh.hpp"
 #include <cassert>
 #include <numeric>
+#include "GLState.hpp"
 
 static auto index(AnyVertexAttribute const& attr)
 {
@@ -31,7 +32,7 @@ Mesh::Mesh(Mesh_Descriptor desc)
 
     { // Vertex Array
         glGenVertexArrays(1, &_vertex_array);
-        glBindVertexArray(_vertex_array);
+        GLState::bind_vertex_array(_vertex_array);
     }
 
     { // Vertex Buffers
@@ -75,7 +76,7 @@ Mesh::Mesh(Mesh_Descriptor desc)
 
 void Mesh::draw() const
 {
-    glBindVertexArray(_vertex_array);
+    GLState::bind_vertex_array(_vertex_array);
     if (_maybe_index_buffer != 0)
         glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(3 * _triangles_count), GL_UNSIGNED_INT, reinterpret_cast<void*>(0)); // NOLINT(*reinterpret-cast)
     else
@@ -85,6 +86,7 @@ void Mesh::draw() const
 Mesh::~Mesh()
 {
     glDeleteVertexArrays(1, &_vertex_array);
+    GLState::forget_vertex_array(_vertex_array);
     if (!_vertex_buffers.empty()) // Might have been moved-from
         glDeleteBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
     glDeleteBuffers(1, &_maybe_index_buffer);
@@ -107,6 +109,7 @@ auto Mesh::operator=(Mesh&& o) noexcept -> Mesh&
     {
         // Delete this
         glDeleteVertexArrays(1, &_vertex_array);
+        GLState::forget_vertex_array(_vertex_array);
         if (!_vertex_buffers.empty()) // Might have been moved-from
             glDeleteBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
         glDeleteBuffers(1, &_maybe_index_buffer);
@@ -0,0 +1,123 @@
+#include "PostProcessGraph.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include "GLState.hpp"
+#include "handle_error.hpp"
+
+namespace {
+class UniqueVertexArray {
+public:
+    UniqueVertexArray() // NOLINT(*-member-init)
+    {
+        glGenVertexArrays(1, &_id);
+    }
+    ~UniqueVertexArray()
+    {
+        glDeleteVertexArrays(1, &_id);
+    }
+    UniqueVertexArray(UniqueVertexArray const&)                    = delete;
+    auto operator=(UniqueVertexArray const&) -> UniqueVertexArray& = delete;
+    UniqueVertexArray(UniqueVertexArray&&)                         = delete;
+    auto operator=(UniqueVertexArray&&) -> UniqueVertexArray&      = delete;
+
+    auto id() const { return _id; }
+
+private:
+    GLuint _id;
+};
+} // namespace
+
+void draw_fullscreen_triangle()
+{
+    static auto const empty_vertex_array = UniqueVertexArray{}; // The core profile doesn't allow drawing without a vertex array, even if it is empty
+    GLState::bind_vertex_array(empty_vertex_array.id());
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+PostProcessGraph::PostProcessGraph(std::vector<PostProcessPass> passes)
+    : _passes{std::move(passes)}
+{
+    auto writer = std::unordered_map<std::string, size_t>{};
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        for (auto const& input : _passes[i].inputs)
+        {
+            if (auto const it = writer.find(input.resource); it != writer.end())
+                _last_reader[input.resource] = i;
+        }
+        auto const& output = _passes[i].output;
+        if (output == screen)
+            continue;
+        if (!writer.emplace(output, i).second)
+            handle_error(std::format("[PostProcessGraph] Resource \"{}\" is written by two passes.", output));
+        _last_reader.emplace(output, i); // If nobody reads it, it can be released right away
+    }
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        for (auto const& input : _passes[i].inputs)
+        {
+            if (auto const it = writer.find(input.resource); it != writer.end() && it->second >= i)
+                handle_error(std::format("[PostProcessGraph] Pass {} reads \"{}\" before it is written by pass {}.", i, input.resource, it->second));
+        }
+    }
+}
+
+void PostProcessGraph::execute(glm::ivec2 size, std::unordered_map<std::string, Texture const*> const& textures)
+{
+    auto targets = std::unordered_map<std::string, RenderTarget*>{}; // The resources that are currently alive
+
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        auto const& pass        = _passes[i];
+        auto const  output_size = glm::max(glm::ivec2{glm::round(glm::vec2{size} * pass.resolution_scale)}, glm::ivec2{1});
+
+        auto const render = [&]() {
+            pass.shader->bind();
+            for (auto const& input : pass.inputs)
+            {
+                if (auto const it = targets.find(input.resource); it != targets.end())
+                {
+                    pass.shader->set_uniform(input.uniform_name, it->second->color_texture(0));
+                }
+                else
+                {
+                    auto const texture = textures.find(input.resource);
+                    if (texture == textures.end())
+                        handle_error(std::format("[PostProcessGraph] Missing texture \"{}\". You must give it to execute().", input.resource));
+                    pass.shader->set_uniform(input.uniform_name, *texture->second);
+                }
+            }
+            pass.shader->set_uniform("resolution", glm::vec2{output_size});
+            if (pass.set_uniforms)
+                pass.set_uniforms(*pass.shader);
+            draw_fullscreen_triangle();
+        };
+
+        if (pass.output == screen)
+        {
+            render();
+        }
+        else
+        {
+            auto& target = _pool.acquire(output_size.x, output_size.y, pass.output_format);
+            target.render(render);
+            targets[pass.output] = &target;
+        }
+
+        // Give back to the pool the targets that won't be read anymore
+        for (auto it = targets.begin(); it != targets.end();)
+        {
+            if (_last_reader.at(it->first) <= i)
+            {
+                _pool.release(*it->second);
+                it = targets.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    _pool.end_frame();
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "RenderTargetPool.hpp"
+#include "Shader.hpp"
+#include "Texture.hpp"
+#include "glm/glm.hpp"
+
+/// Draws a triangle that covers the whole viewport. Use it with a shader whose vertex shader is "res/fullscreen.vert".
+/// It doesn't need any vertex buffer, so all the full-screen passes share the same empty vertex array.
+void draw_fullscreen_triangle();
+
+struct PostProcessInput {
+    std::string uniform_name; // The sampler2D of the shader that will read the texture
+    std::string resource;     // The output of a previous pass, or a texture given to PostProcessGraph::execute()
+};
+
+struct PostProcessPass {
+    Shader const*                 shader{};  // Must use "res/fullscreen.vert" as its vertex shader. It also receives the size of its output in the `resolution` uniform.
+    std::vector<PostProcessInput> inputs{};
+    std::string                   output{};  // Name of the resource that this pass writes, or PostProcessGraph::screen to write to the framebuffer that is bound when you call execute()
+    InternalFormat_Color          output_format{InternalFormat_Color::RGBA16F};
+    float                         resolution_scale{1.f}; // The output is this times the size given to execute(), e.g. 0.5 for a half-resolution pass
+
+    std::function<void(Shader const&)> set_uniforms{}; // Called after the shader has been bound, to set the uniforms that are not inputs
+};
+
+/// A list of full-screen passes, each one reading the outputs of the previous ones.
+/// The intermediate outputs are rendered in RenderTargets taken from a pool, and each target goes back to the pool right after the last pass that reads it.
+/// So two resources whose lifetimes don't overlap share the same target, and the targets are reused from one frame to the next.
+/// For example, to apply "res/postProcess.frag" to the scene and its bloom, and then display the result with "res/display.frag":
+///     auto post_process = PostProcessGraph{{
+///         {.shader = &post_process_shader, .inputs = {{"tex", "scene"}, {"bloomTex", "bloom"}}, .output = "post_processed"},
+///         {.shader = &display_shader, .inputs = {{"tex", "post_processed"}}, .output = std::string{PostProcessGraph::screen}},
+///     }};
+///     post_process.execute(size, {{"scene", &scene_texture}, {"bloom", &bloom.texture()}}); // Each frame
+class PostProcessGraph {
+public:
+    static constexpr std::string_view screen{"screen"};
+
+    /// The passes run in this order. Calls handle_error() if a pass reads a resource that is written by a later pass, or if two passes write the same resource.
+    explicit PostProcessGraph(std::vector<PostProcessPass> passes);
+
+    /// Runs all the passes.
+    /// @param size The size of the screen (i.e. of the passes whose resolution_scale is 1).
+    /// @param textures The resources that are not written by any pass (e.g. the image rendered by the scene), by name.
+    void execute(glm::ivec2 size, std::unordered_map<std::string, Texture const*> const& textures);
+
+    auto pool() const -> RenderTargetPool const& { return _pool; }
+
+private:
+    std::vector<PostProcessPass>            _passes;
+    std::unordered_map<std::string, size_t> _last_reader{}; // For each resource written by a pass: index of the last pass that reads it
+    RenderTargetPool                        _pool{};
+};
@@ -0,0 +1,236 @@
+#include "RenderGraph.hpp"
+#include <algorithm>
+#include <cassert>
+#include <format>
+#include <limits>
+#include <optional>
+#include "ComputeShader.hpp"
+#include "handle_error.hpp"
+
+static constexpr size_t no_pass = std::numeric_limits<size_t>::max();
+
+auto RenderGraphContext::texture(RenderGraphResource resource) const -> Texture const&
+{
+    auto const& res = _graph._resources.at(resource.index);
+    if (auto const* texture = std::get_if<Texture const*>(&res.source))
+        return **texture;
+    if (auto const* target = std::get_if<RenderTarget*>(&res.source))
+        return (*target)->color_texture(0);
+    assert(res.acquired && "This resource is not used by the current pass. Add it to the reads or writes of the pass.");
+    return res.acquired->color_texture(0);
+}
+
+auto RenderGraphContext::render_target(RenderGraphResource resource) const -> RenderTarget&
+{
+    auto const& res = _graph._resources.at(resource.index);
+    if (auto const* target = std::get_if<RenderTarget*>(&res.source))
+        return **target;
+    assert(!std::holds_alternative<Texture const*>(res.source) && "You can't render to an imported Texture. Use RenderGraph::import_render_target() instead.");
+    assert(res.acquired && "This resource is not used by the current pass. Add it to the writes of the pass.");
+    return *res.acquired;
+}
+
+auto RenderGraph::create(std::string name, GLsizei width, GLsizei height, InternalFormat_Color format) -> RenderGraphResource
+{
+    _resources.push_back(Resource{.name = std::move(name), .source = Transient{width, height, format}});
+    return {static_cast<uint32_t>(_resources.size() - 1)};
+}
+
+auto RenderGraph::import_texture(std::string name, Texture const& texture) -> RenderGraphResource
+{
+    _resources.push_back(Resource{.name = std::move(name), .source = &texture});
+    return {static_cast<uint32_t>(_resources.size() - 1)};
+}
+
+auto RenderGraph::import_render_target(std::string name, RenderTarget& target) -> RenderGraphResource
+{
+    _resources.push_back(Resource{.name = std::move(name), .source = &target});
+    return {static_cast<uint32_t>(_resources.size() - 1)};
+}
+
+void RenderGraph::add_pass(RenderGraphPass pass)
+{
+    _passes.push_back(std::move(pass));
+}
+
+void RenderGraph::mark_as_output(RenderGraphResource resource)
+{
+    assert(!std::holds_alternative<Transient>(_resources.at(resource.index).source) && "A transient resource doesn't survive the graph, so it can't be an output. Import the texture instead.");
+    _resources.at(resource.index).is_output = true;
+}
+
+auto RenderGraph::sorted_passes_to_run() const -> std::vector<size_t>
+{
+    auto writer = std::vector<size_t>(_resources.size(), no_pass);
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        for (auto const& usage : _passes[i].writes)
+        {
+            auto& w = writer.at(usage.resource.index);
+            if (w != no_pass && w != i)
+                handle_error(std::format("[RenderGraph] Resource \"{}\" is written by two passes: \"{}\" and \"{}\".", _resources[usage.resource.index].name, _passes[w].name, _passes[i].name));
+            w = i;
+        }
+    }
+
+    // Culling: starting from the passes that have to run, walk back through the passes they depend on
+    auto is_needed = std::vector<bool>(_passes.size(), false);
+    auto to_visit  = std::vector<size_t>{};
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        auto const writes_an_output = std::any_of(_passes[i].writes.begin(), _passes[i].writes.end(), [&](RenderGraphUsage const& usage) {
+            return _resources[usage.resource.index].is_output;
+        });
+        if (_passes[i].has_side_effects || writes_an_output)
+        {
+            is_needed[i] = true;
+            to_visit.push_back(i);
+        }
+    }
+    while (!to_visit.empty())
+    {
+        auto const pass = to_visit.back();
+        to_visit.pop_back();
+        for (auto const& usage : _passes[pass].reads)
+        {
+            auto const w = writer.at(usage.resource.index);
+            if (w == no_pass)
+            {
+                if (std::holds_alternative<Transient>(_resources[usage.resource.index].source))
+                    handle_error(std::format("[RenderGraph] Pass \"{}\" reads \"{}\", but no pass writes it.", _passes[pass].name, _resources[usage.resource.index].name));
+                continue;
+            }
+            if (!is_needed[w])
+            {
+                is_needed[w] = true;
+                to_visit.push_back(w);
+            }
+        }
+    }
+
+    // Topological sort. When several passes are ready, the one that was added first runs first, so that the order stays predictable.
+    auto is_sorted = std::vector<bool>(_passes.size(), false);
+    auto order     = std::vector<size_t>{};
+    auto const is_ready = [&](size_t pass) {
+        return std::all_of(_passes[pass].reads.begin(), _passes[pass].reads.end(), [&](RenderGraphUsage const& usage) {
+            auto const w = writer[usage.resource.index];
+            return w == no_pass || w == pass || is_sorted[w];
+        });
+    };
+    auto const needed_count = static_cast<size_t>(std::count(is_needed.begin(), is_needed.end(), true));
+    while (order.size() < needed_count)
+    {
+        auto next = no_pass;
+        for (size_t i = 0; i < _passes.size() && next == no_pass; ++i)
+        {
+            if (is_needed[i] && !is_sorted[i] && is_ready(i))
+                next = i;
+        }
+        if (next == no_pass)
+            handle_error("[RenderGraph] The dependencies between the passes have a cycle.");
+        is_sorted[next] = true;
+        order.push_back(next);
+    }
+    return order;
+}
+
+static auto barrier_for(RenderGraphAccess access) -> GLbitfield
+{
+    switch (access)
+    {
+    case RenderGraphAccess::Sampled:
+        return GL_TEXTURE_FETCH_BARRIER_BIT;
+    case RenderGraphAccess::ImageLoad:
+    case RenderGraphAccess::ImageStore:
+        return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+    case RenderGraphAccess::ColorAttachment:
+        return GL_FRAMEBUFFER_BARRIER_BIT;
+    }
+    return GL_ALL_BARRIER_BITS;
+}
+
+void RenderGraph::execute()
+{
+    auto const order = sorted_passes_to_run();
+
+    // Lifetimes of the transient resources, as positions in order
+    auto first_use = std::vector<size_t>(_resources.size(), no_pass);
+    auto last_use  = std::vector<size_t>(_resources.size(), no_pass);
+    for (size_t position = 0; position < order.size(); ++position)
+    {
+        auto const& pass = _passes[order[position]];
+        for (auto const* usages : {&pass.reads, &pass.writes})
+        {
+            for (auto const& usage : *usages)
+            {
+                first_use[usage.resource.index] = std::min(first_use[usage.resource.index], position);
+                last_use[usage.resource.index]  = position;
+            }
+        }
+    }
+
+    // For each resource written with imageStore(), the barrier bits that have been issued since that write
+    auto covered_barriers = std::vector<std::optional<GLbitfield>>(_resources.size());
+
+    _executed_passes.clear();
+    for (size_t position = 0; position < order.size(); ++position)
+    {
+        auto const& pass = _passes[order[position]];
+
+        GLbitfield barriers = 0;
+        for (auto const* usages : {&pass.reads, &pass.writes})
+        {
+            for (auto const& usage : *usages)
+            {
+                auto& resource = _resources[usage.resource.index];
+                if (first_use[usage.resource.index] == position)
+                {
+                    if (auto const* transient = std::get_if<Transient>(&resource.source))
+                        resource.acquired = &_pool.acquire(transient->width, transient->height, transient->format);
+                }
+                if (auto const covered = covered_barriers[usage.resource.index])
+                    barriers |= barrier_for(usage.access) & ~*covered;
+            }
+        }
+        if (barriers != 0)
+        {
+            memory_barrier(static_cast<Barrier>(barriers));
+            for (auto& covered : covered_barriers)
+            {
+                if (covered)
+                    *covered |= barriers; // A barrier applies to all the writes that came before it, not only to the ones of this resource
+            }
+        }
+
+        pass.execute(RenderGraphContext{*this});
+        _executed_passes.push_back(pass.name);
+
+        for (auto const& usage : pass.writes)
+        {
+            if (usage.access == RenderGraphAccess::ImageStore)
+                covered_barriers[usage.resource.index] = GLbitfield{0};
+        }
+        for (size_t i = 0; i < _resources.size(); ++i)
+        {
+            if (last_use[i] == position && _resources[i].acquired)
+            {
+                _pool.release(*_resources[i].acquired);
+                _resources[i].acquired = nullptr;
+            }
+        }
+    }
+
+    // The outputs are going to be used after the graph, in ways we don't know
+    GLbitfield output_barriers = 0;
+    for (size_t i = 0; i < _resources.size(); ++i)
+    {
+        if (_resources[i].is_output && covered_barriers[i])
+            output_barriers |= ~*covered_barriers[i] & (GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    }
+    if (output_barriers != 0)
+        memory_barrier(static_cast<Barrier>(output_barriers));
+
+    _pool.end_frame();
+    _passes.clear();
+    _resources.clear();
+}
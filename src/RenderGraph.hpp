@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <variant>
+#include <vector>
+#include "RenderTarget.hpp"
+#include "RenderTargetPool.hpp"
+#include "Texture.hpp"
+
+struct RenderGraphResource {
+    uint32_t index{};
+};
+
+enum class RenderGraphAccess {
+    Sampled,         // Read with texture() / texelFetch()
+    ImageLoad,       // Read with imageLoad()
+    ImageStore,      // Written with imageStore(), e.g. by a compute shader
+    ColorAttachment, // Rendered to, through RenderGraphContext::render_target()
+};
+
+struct RenderGraphUsage {
+    RenderGraphResource resource{};
+    RenderGraphAccess   access{};
+};
+
+class RenderGraphContext;
+
+struct RenderGraphPass {
+    std::string                                    name{};
+    std::vector<RenderGraphUsage>                  reads{};
+    std::vector<RenderGraphUsage>                  writes{};
+    bool                                           has_side_effects{false}; // e.g. renders to the screen: the pass is never culled
+    std::function<void(RenderGraphContext const&)> execute{};
+};
+
+/// Given to RenderGraphPass::execute to access the actual textures of the resources.
+class RenderGraphContext {
+public:
+    auto texture(RenderGraphResource) const -> Texture const&;
+    /// Only for the resources that were created by RenderGraph::create(), or imported with RenderGraph::import_render_target().
+    auto render_target(RenderGraphResource) const -> RenderTarget&;
+
+private:
+    friend class RenderGraph;
+    explicit RenderGraphContext(class RenderGraph const& graph)
+        : _graph{graph}
+    {}
+    class RenderGraph const& _graph;
+};
+
+/// Describes everything that is rendered during a frame as passes that read and write resources, and then runs them:
+/// - The passes run in an order that respects their dependencies (a pass runs after the ones that write what it reads), whatever the order in which you add them.
+/// - The passes whose outputs are not used by anything (neither by a pass with side effects, nor marked with mark_as_output()) are not run at all. So you can add all the passes every frame, and the ones of the disabled features cost nothing.
+/// - The resources created by the graph are taken from a pool right before their first use, and given back right after their last use, so resources whose lifetimes don't overlap share the same memory.
+/// - glMemoryBarrier() is called before each pass that reads something written with imageStore(), with only the barrier bits that the reads need.
+/// Build it again each frame: execute() clears the passes and resources, but keeps the pool.
+class RenderGraph {
+public:
+    /// A transient texture, allocated by the graph.
+    auto create(std::string name, GLsizei width, GLsizei height, InternalFormat_Color format) -> RenderGraphResource;
+    /// A texture that lives outside of the graph (e.g. loaded from a file, or kept from one frame to the next).
+    auto import_texture(std::string name, Texture const&) -> RenderGraphResource;
+    auto import_render_target(std::string name, RenderTarget&) -> RenderGraphResource;
+
+    /// Each resource can only be written by one pass (that pass can also read it).
+    void add_pass(RenderGraphPass);
+    /// The imported resource is needed after the graph has run, so the passes that compute it must not be culled.
+    void mark_as_output(RenderGraphResource);
+
+    /// Calls handle_error() if the dependencies between the passes have a cycle.
+    void execute();
+
+    /// Names of the passes that were run by the last execute(), in the order in which they were run. Useful for debugging.
+    auto executed_passes() const -> std::vector<std::string> const& { return _executed_passes; }
+
+private:
+    friend class RenderGraphContext;
+    struct Transient {
+        GLsizei              width;
+        GLsizei              height;
+        InternalFormat_Color format;
+    };
+    struct Resource {
+        std::string                                            name;
+        std::variant<Transient, Texture const*, RenderTarget*> source;
+        RenderTarget*                                          acquired{nullptr}; // Only for the transient resources, while they are alive
+        bool                                                   is_output{false};
+    };
+
+    auto sorted_passes_to_run() const -> std::vector<size_t>;
+
+private:
+    std::vector<Resource>        _resources{};
+    std::vector<RenderGraphPass> _passes{};
+    RenderTargetPool             _pool{};
+    std::vector<std::string>     _executed_passes{};
+};
@@ -1,8 +1,18 @@
 #include "RenderTarget.hpp"
-#include <array>
+#include <algorithm>
 #include "Texture.hpp"
 #include "handle_error.hpp"
 
+static constexpr GLsizei bucket_size{128};
+static constexpr auto    settle_delay = std::chrono::milliseconds{250}; // Interactive resizing sends a new size every frame, we don't want to reallocate for each of them
+
+static auto allocation_size(GLsizei size, ResizePolicy policy) -> GLsizei
+{
+    if (policy == ResizePolicy::Exact)
+        return size;
+    return std::max((size + bucket_size - 1) / bucket_size, 1) * bucket_size;
+}
+
 static GLenum attachment_type(InternalFormat_DepthStencil format)
 {
     switch (format)
@@ -21,9 +31,33 @@ static GLenum attachment_type(InternalFormat_DepthStencil format)
     }
 };
 
+static auto make_renderbuffer(GLenum format, RenderTarget_Descriptor const& desc) -> UniqueRenderbuffer
+{
+    auto renderbuffer = UniqueRenderbuffer{};
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer.id());
+    if (desc.samples_count > 1)
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, desc.samples_count, format, desc.width, desc.height);
+    else
+        glRenderbufferStorage(GL_RENDERBUFFER, format, desc.width, desc.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    return renderbuffer;
+}
+
+/// By default a framebuffer only draws into its first color attachment
+static void draw_into_all_color_attachments(size_t color_attachments_count)
+{
+    auto draw_buffers = std::vector<GLenum>{};
+    for (size_t i = 0; i < color_attachments_count; ++i)
+        draw_buffers.push_back(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i));
+    glDrawBuffers(static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
+}
+
 void RenderTarget::create_attachments(RenderTarget_Descriptor const& desc)
 {
     _color_textures.clear();
+    _color_renderbuffers.clear();
+    _depth_stencil_texture.reset();
+    _depth_stencil_renderbuffer.reset();
     render([&]() { // HACK, we reuse render() as a way to have our framebuffer bound
         if (desc.color_textures.empty())
         { // We need to explicitly do this when have no color texture
@@ -33,6 +67,12 @@ void RenderTarget::create_attachments(RenderTarget_Descriptor const& desc)
         for (size_t i = 0; i < desc.color_textures.size(); ++i)
         {
             auto const& color_texture = desc.color_textures[i];
+            if (desc.samples_count > 1)
+            {
+                _color_renderbuffers.push_back(make_renderbuffer(static_cast<GLenum>(color_texture.format), desc));
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_RENDERBUFFER, _color_renderbuffers.back().id());
+                continue;
+            }
             _color_textures.emplace_back(
                 TextureSource::EmptyImage{
                     .width          = desc.width,
@@ -43,7 +83,12 @@ void RenderTarget::create_attachments(RenderTarget_Descriptor const& desc)
             );
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, _color_textures.back().id(), 0);
         }
-        if (desc.depth_stencil_texture.has_value())
+        if (desc.depth_stencil_texture.has_value() && (desc.samples_count > 1 || !desc.depth_stencil_texture->is_sampled))
+        {
+            _depth_stencil_renderbuffer.emplace(make_renderbuffer(static_cast<GLenum>(desc.depth_stencil_texture->format), desc));
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment_type(desc.depth_stencil_texture->format), GL_RENDERBUFFER, _depth_stencil_renderbuffer->id());
+        }
+        else if (desc.depth_stencil_texture.has_value())
         {
             _depth_stencil_texture.emplace(
                 TextureSource::EmptyImage{
@@ -55,6 +100,8 @@ void RenderTarget::create_attachments(RenderTarget_Descriptor const& desc)
             );
             glFramebufferTexture2D(GL_FRAMEBUFFER, attachment_type(desc.depth_stencil_texture->format), GL_TEXTURE_2D, _depth_stencil_texture->id(), 0);
         }
+        if (desc.color_textures.size() > 1)
+            draw_into_all_color_attachments(desc.color_textures.size());
         auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
         if (status != GL_FRAMEBUFFER_COMPLETE)
         {
@@ -88,39 +135,131 @@ void RenderTarget::create_attachments(RenderTarget_Descriptor const& desc)
     });
 }
 
+static auto max_samples_count() -> GLsizei
+{
+    static GLsizei const max = []() {
+        GLint res{};
+        glGetIntegerv(GL_MAX_SAMPLES, &res);
+        return static_cast<GLsizei>(res);
+    }();
+    return max;
+}
+
 RenderTarget::RenderTarget(RenderTarget_Descriptor const& desc)
     : _desc{desc}
+    , _width{desc.width}
+    , _height{desc.height}
 {
     assert(!desc.color_textures.empty() || desc.depth_stencil_texture.has_value());
-    create_attachments(desc);
+    assert(desc.samples_count >= 1);
+    _desc.samples_count = std::min(desc.samples_count, max_samples_count());
+    _desc.width  = allocation_size(desc.width, desc.resize_policy);
+    _desc.height = allocation_size(desc.height, desc.resize_policy);
+    create_attachments(_desc);
 }
 
 void RenderTarget::render(std::function<void()> const& render_fn)
 {
-    // Store previous state to restore it at the end
-    int                previous_draw_framebuffer{};
-    int                previous_read_framebuffer{};
-    std::array<int, 4> previous_viewport{};
-    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_draw_framebuffer);
-    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_framebuffer);
-    glGetIntegerv(GL_VIEWPORT, previous_viewport.data());
+    apply_pending_reallocation();
+
+    // Store previous state to restore it at the end (read from GLState, so this doesn't query the driver)
+    auto const previous_draw_framebuffer = GLState::draw_framebuffer();
+    auto const previous_read_framebuffer = GLState::read_framebuffer();
+    auto const previous_viewport         = GLState::viewport();
 
     // Bind our framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, _id.id());
-    glViewport(0, 0, _desc.width, _desc.height);
+    GLState::bind_framebuffer(GL_FRAMEBUFFER, _id.id());
+    GLState::set_viewport({0, 0, width(), height()});
+
+    if (_desc.min_sample_shading.has_value() && _desc.samples_count > 1)
+    {
+        GLState::set_enabled(GL_SAMPLE_SHADING, true);
+        glMinSampleShading(*_desc.min_sample_shading);
+    }
 
     // Render
     render_fn();
 
+    if (_desc.min_sample_shading.has_value() && _desc.samples_count > 1)
+        GLState::set_enabled(GL_SAMPLE_SHADING, false);
+
     // Re-bind previous framebuffer
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous_draw_framebuffer);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, previous_read_framebuffer);
-    glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+    GLState::bind_framebuffer(GL_DRAW_FRAMEBUFFER, previous_draw_framebuffer);
+    GLState::bind_framebuffer(GL_READ_FRAMEBUFFER, previous_read_framebuffer);
+    GLState::set_viewport(previous_viewport);
 }
 
 void RenderTarget::resize(int width, int height)
 {
-    _desc.width  = width;
-    _desc.height = height;
+    _width  = width;
+    _height = height;
+    if (_desc.resize_policy == ResizePolicy::Exact)
+    {
+        if (width == _desc.width && height == _desc.height)
+            return;
+        _desc.width  = width;
+        _desc.height = height;
+        create_attachments(_desc);
+        return;
+    }
+
+    auto const needed_width  = allocation_size(width, _desc.resize_policy);
+    auto const needed_height = allocation_size(height, _desc.resize_policy);
+    auto const fits          = width <= _desc.width && height <= _desc.height;
+    // When shrinking, we keep the big textures unless they waste most of their memory
+    auto const is_too_big = static_cast<int64_t>(needed_width) * needed_height * 2 < static_cast<int64_t>(_desc.width) * _desc.height;
+    if (fits && !is_too_big)
+        _last_resize_time.reset();
+    else
+        _last_resize_time = std::chrono::steady_clock::now();
+}
+
+void RenderTarget::apply_pending_reallocation()
+{
+    if (!_last_resize_time || std::chrono::steady_clock::now() - *_last_resize_time < settle_delay)
+        return;
+    _last_resize_time.reset();
+    _desc.width  = allocation_size(_width, _desc.resize_policy);
+    _desc.height = allocation_size(_height, _desc.resize_policy);
     create_attachments(_desc);
+}
+
+void RenderTarget::resolve_to(RenderTarget& destination) const
+{
+    assert(destination.samples_count() == 1 && "You can only resolve into a RenderTarget that isn't multisampled.");
+    auto const previous_draw_framebuffer = GLState::draw_framebuffer();
+    auto const previous_read_framebuffer = GLState::read_framebuffer();
+    GLState::bind_framebuffer(GL_READ_FRAMEBUFFER, _id.id());
+    GLState::bind_framebuffer(GL_DRAW_FRAMEBUFFER, destination._id.id());
+
+    // When resolving, the source and destination rectangles must be the same
+    auto const width  = std::min(this->width(), destination.width());
+    auto const height = std::min(this->height(), destination.height());
+    auto const colors_count = std::min(_desc.color_textures.size(), destination._desc.color_textures.size());
+    for (size_t i = 0; i < colors_count; ++i)
+    {
+        glReadBuffer(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i));
+        glDrawBuffer(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i));
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    if (colors_count > 0)
+    { // Back to what create_attachments() did
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        draw_into_all_color_attachments(destination._desc.color_textures.size());
+    }
+    if (_desc.depth_stencil_texture.has_value() && destination._desc.depth_stencil_texture.has_value())
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST); // Depth can't be averaged, each pixel gets the value of one of its samples
+
+    GLState::bind_framebuffer(GL_DRAW_FRAMEBUFFER, previous_draw_framebuffer);
+    GLState::bind_framebuffer(GL_READ_FRAMEBUFFER, previous_read_framebuffer);
+}
+
+auto RenderTarget::events_callbacks() -> EventsCallbacks
+{
+    return EventsCallbacks{
+        .on_framebuffer_resized = [this](FramebufferResizedEvent const& e) {
+            if (e.width_in_pixels > 0 && e.height_in_pixels > 0) // The framebuffer has a size of 0 while the window is minimized
+                resize(e.width_in_pixels, e.height_in_pixels);
+        },
+    };
 }
\ No newline at end of file
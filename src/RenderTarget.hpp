@@ -1,7 +1,11 @@
 #pragma once
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <optional>
 #include <format>
+#include "EventsCallbacks.hpp"
+#include "GLState.hpp"
 #include "Texture.hpp"
 #include <glad/glad.h>
 
@@ -14,6 +18,7 @@ public:
     ~UniqueFramebuffer()
     {
         glDeleteFramebuffers(1, &_id);
+        GLState::forget_framebuffer(_id);
     }
     UniqueFramebuffer(UniqueFramebuffer const&)                    = delete; // You cannot copy
     auto operator=(UniqueFramebuffer const&) -> UniqueFramebuffer& = delete; // a RenderTarget. But you can move it, using std::move(my_render_target)
@@ -27,6 +32,41 @@ public:
         if (&o != this)
         {
             glDeleteFramebuffers(1, &_id);
+            GLState::forget_framebuffer(_id);
+            _id   = o._id;
+            o._id = 0;
+        }
+        return *this;
+    }
+
+    auto id() const { return _id; }
+
+private:
+    GLuint _id;
+};
+
+class UniqueRenderbuffer {
+public:
+    UniqueRenderbuffer() // NOLINT(*-member-init)
+    {
+        glGenRenderbuffers(1, &_id);
+    }
+    ~UniqueRenderbuffer()
+    {
+        glDeleteRenderbuffers(1, &_id);
+    }
+    UniqueRenderbuffer(UniqueRenderbuffer const&)                    = delete; // You cannot copy
+    auto operator=(UniqueRenderbuffer const&) -> UniqueRenderbuffer& = delete; // a renderbuffer. But you can move it
+    UniqueRenderbuffer(UniqueRenderbuffer&& o) noexcept
+        : _id{o._id}
+    {
+        o._id = 0;
+    }
+    auto operator=(UniqueRenderbuffer&& o) noexcept -> UniqueRenderbuffer&
+    {
+        if (&o != this)
+        {
+            glDeleteRenderbuffers(1, &_id);
             _id   = o._id;
             o._id = 0;
         }
@@ -47,6 +87,14 @@ struct ColorAttachment_Descriptor {
 struct DepthStencilAttachment_Descriptor {
     InternalFormat_DepthStencil format{};
     TextureOptions              options{};
+    bool                        is_sampled{true}; // If you never read the depth in a shader, set this to false: it will be stored in a renderbuffer, that the driver can keep in faster memory (and you won't be able to call depth_stencil_texture()).
+};
+
+enum class ResizePolicy {
+    Exact,   // resize() reallocates the textures right away, with exactly the requested size.
+    Buckets, // The textures are allocated with a size rounded up to a multiple of 128 pixels, and we render to the sub-viewport of the requested size.
+             // resize() doesn't reallocate anything as long as the new size fits, and otherwise waits for the size to stop changing for a moment before reallocating.
+             // Use this for targets that follow the size of the window (see events_callbacks()). When sampling color_texture(), multiply your UVs by uv_scale().
 };
 
 struct RenderTarget_Descriptor {
@@ -54,6 +102,13 @@ struct RenderTarget_Descriptor {
     GLsizei                                          height{};
     std::vector<ColorAttachment_Descriptor>          color_textures{};
     std::optional<DepthStencilAttachment_Descriptor> depth_stencil_texture{};
+    ResizePolicy                                     resize_policy{ResizePolicy::Exact};
+    /// Number of samples per pixel, for multisample antialiasing (MSAA). Edges get antialiased for a fraction of the cost of rendering at a higher resolution.
+    /// When it is more than 1, all the attachments are multisampled renderbuffers: you can't sample them, call resolve_to() to get a regular texture.
+    GLsizei                                          samples_count{1};
+    /// By default MSAA runs the fragment shader only once per pixel, and only the edges of the triangles get antialiased.
+    /// Set this between 0 and 1 to run it for (at least) that fraction of the samples, which also antialiases the aliasing that comes from the shader (e.g. specular highlights), but costs more.
+    std::optional<float>                             min_sample_shading{};
 };
 
 class RenderTarget {
@@ -62,21 +117,48 @@ public:
 
     void render(std::function<void()> const& render_fn);
     void resize(GLsizei width, GLsizei height);
+    /// Averages the samples of this multisampled target, and writes the result into destination, which must not be multisampled.
+    /// Each color attachment is resolved into the color attachment of destination that has the same index. The depth is also copied if both targets have one.
+    void resolve_to(RenderTarget& destination) const;
+    /// Resizes the target whenever the window's framebuffer is resized. Give them to ImGuiWrapper::set_events_callbacks().
+    /// The RenderTarget must not be moved while these callbacks are in use.
+    auto events_callbacks() -> EventsCallbacks;
+
+    /// The size of the area that we render to. With ResizePolicy::Buckets it can be smaller than the textures (see uv_scale()).
+    /// And while a reallocation is pending, it can also be smaller than the size you asked for.
+    auto width() const -> GLsizei { return std::min(_width, _desc.width); }
+    auto height() const -> GLsizei { return std::min(_height, _desc.height); }
+    /// The part of the textures that has been rendered to: multiply your UVs by this when you sample color_texture().
+    /// Always 1 with ResizePolicy::Exact.
+    auto uv_scale() const -> glm::vec2 { return glm::vec2{width(), height()} / glm::vec2{_desc.width, _desc.height}; }
+
+    auto samples_count() const -> GLsizei { return _desc.samples_count; }
 
-    auto color_texture(size_t index) const -> Texture const& { return _color_textures.at(index); }
+    auto color_texture(size_t index) const -> Texture const&
+    {
+        assert(_desc.samples_count == 1 && "A multisampled RenderTarget has no texture. Use resolve_to() to copy it into a RenderTarget that isn't multisampled.");
+        return _color_textures.at(index);
+    }
     auto depth_stencil_texture() const -> Texture const&
     {
-        assert(_depth_stencil_texture.has_value() && "You didn't create this RenderTarget with a depth_stencil_texture. See RenderTarget_Descriptor.");
+        assert(_depth_stencil_texture.has_value() && "You didn't create this RenderTarget with a depth_stencil_texture, or you set is_sampled to false, or the RenderTarget is multisampled. See RenderTarget_Descriptor.");
         return *_depth_stencil_texture;
     }
 
 private:
     void create_attachments(RenderTarget_Descriptor const& desc);
+    void apply_pending_reallocation();
 
 private:
     UniqueFramebuffer _id{};
-    std::vector<Texture>        _color_textures{};
-    std::optional<Texture>      _depth_stencil_texture{};
+    std::vector<Texture>              _color_textures{};
+    std::optional<Texture>            _depth_stencil_texture{};
+    std::vector<UniqueRenderbuffer>   _color_renderbuffers{};        // Used instead of _color_textures when the target is multisampled
+    std::optional<UniqueRenderbuffer> _depth_stencil_renderbuffer{}; // Used instead of _depth_stencil_texture when it is multisampled or not sampled
+
+    RenderTarget_Descriptor _desc{}; // width and height are the size of the textures
+    GLsizei                 _width{}; // The size that has been asked for
+    GLsizei                 _height{};
 
-    RenderTarget_Descriptor _desc{};
+    std::optional<std::chrono::steady_clock::time_point> _last_resize_time{}; // Set while the textures need to be reallocated, once the size has settled
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "RenderTargetPool.hpp"
+#include <algorithm>
+#include <cassert>
+
+auto RenderTargetPool::acquire(GLsizei width, GLsizei height, InternalFormat_Color format) -> RenderTarget&
+{
+    auto const it = std::find_if(_entries.begin(), _entries.end(), [&](Entry const& entry) {
+        return !entry.is_in_use
+               && entry.format == format
+               && entry.target->width() == width
+               && entry.target->height() == height;
+    });
+    auto& entry = it != _entries.end()
+                      ? *it
+                      : _entries.emplace_back(Entry{
+                          .target = std::make_unique<RenderTarget>(RenderTarget_Descriptor{
+                              .width          = width,
+                              .height         = height,
+                              .color_textures = {ColorAttachment_Descriptor{.format = format}},
+                          }),
+                          .format = format,
+                      });
+    entry.is_in_use           = true;
+    entry.unused_frames_count = 0;
+    return *entry.target;
+}
+
+void RenderTargetPool::release(RenderTarget const& target)
+{
+    auto const it = std::find_if(_entries.begin(), _entries.end(), [&](Entry const& entry) { return entry.target.get() == &target; });
+    assert(it != _entries.end() && it->is_in_use && "This RenderTarget has not been acquired from this pool.");
+    it->is_in_use = false;
+}
+
+void RenderTargetPool::end_frame(int frames_count)
+{
+    for (auto& entry : _entries)
+    {
+        if (!entry.is_in_use)
+            entry.unused_frames_count++;
+    }
+    std::erase_if(_entries, [&](Entry const& entry) { return !entry.is_in_use && entry.unused_frames_count > frames_count; });
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "RenderTarget.hpp"
+
+/// Keeps RenderTargets around so that passes that need a temporary target can reuse the ones of the previous passes (and of the previous frames) instead of allocating new ones.
+/// Targets are matched on their size and color format.
+class RenderTargetPool {
+public:
+    /// Returns a RenderTarget with a single color texture of this size and format, that nobody else is using. Its content is undefined.
+    /// The reference stays valid until you release() it.
+    auto acquire(GLsizei width, GLsizei height, InternalFormat_Color format) -> RenderTarget&;
+    /// Gives the target back to the pool, so that the next acquire() can return it.
+    void release(RenderTarget const&);
+
+    /// Deletes the targets that haven't been acquired during the last frames_count calls to end_frame().
+    void end_frame(int frames_count = 3);
+
+    auto targets_count() const -> size_t { return _entries.size(); }
+
+private:
+    struct Entry {
+        std::unique_ptr<RenderTarget> target;
+        InternalFormat_Color          format;
+        bool                          is_in_use{false};
+        int                           unused_frames_count{0};
+    };
+    std::vector<Entry> _entries{};
+};
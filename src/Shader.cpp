@@ -1,102 +1,242 @@
 #include "Shader.hpp"
 #include <cassert>
-#include <fstream>
+#include "AssetArchive.hpp"
+#include "GLState.hpp"
+#include "ShaderBinaryCache.hpp"
+#include "ShaderPreprocessor.hpp"
 #include "Texture.hpp"
+#include "glfw.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "handle_error.hpp"
-#include "make_absolute_path.hpp"
 
 void compile_shader_module(GLuint id, std::string const& source_code)
 {
     char const* src = source_code.c_str();
     glShaderSource(id, 1, &src, nullptr);
     glCompileShader(id);
+}
 
-    { // Check for errors
-        int result;
-        glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-        if (result)
-            return; // Compilation successful
-
-        GLsizei length;
-        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-        std::vector<GLchar> error_message;
-        error_message.resize(static_cast<size_t>(length));
-        glGetShaderInfoLog(id, length, nullptr, error_message.data());
-        handle_error(std::format("Shader Compilation failed:\n{}\n\nThe code we tried to compile was:\n{}", error_message.data(), source_code));
-    }
+static auto compilation_error(GLuint id, std::string const& source_code) -> std::optional<std::string>
+{
+    int result;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &result);
+    if (result)
+        return std::nullopt; // Compilation successful
+
+    GLsizei length;
+    glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> error_message;
+    error_message.resize(static_cast<size_t>(length));
+    glGetShaderInfoLog(id, length, nullptr, error_message.data());
+    return std::format("Shader Compilation failed:\n{}\n\nThe code we tried to compile was:\n{}", error_message.data(), source_code);
 }
 
-auto get_source_code(ShaderSource::Code const& source) -> std::string
+auto get_source_code(ShaderSource::Code const& source, std::span<ShaderDefine const> defines, std::vector<std::filesystem::path>* files) -> std::string
 {
-    return source.code;
+    return preprocess_shader(source.code, {}, defines, files);
 }
-auto get_source_code(ShaderSource::File const& source) -> std::string
+auto get_source_code(ShaderSource::File const& source, std::span<ShaderDefine const> defines, std::vector<std::filesystem::path>* files) -> std::string
 {
-    auto ifs = std::ifstream{make_absolute_path(source.path)};
-    return std::string{std::istreambuf_iterator<char>{ifs}, {}};
+    // With hot reload (files != nullptr) we watch the files on disk, so that's what we must read, not the copy in assets.pak
+    auto const code = files ? read_loose_asset(source.path) : read_asset(source.path);
+    return preprocess_shader(code.as_string_view(), source.path, defines, files);
 }
 
-class UniqueShaderModule {
-public:
-    explicit UniqueShaderModule(GLenum shader_kind, AnyShaderSource const& source)
-        : _id{glCreateShader(shader_kind)}
-    {
-        compile_shader_module(_id, std::visit([](auto&& source) { return get_source_code(source); }, source));
-    }
-    ~UniqueShaderModule()
+static auto linking_error(GLuint shader_id) -> std::optional<std::string>
+{
+    int result;
+    glGetProgramiv(shader_id, GL_LINK_STATUS, &result);
+    if (result != GL_FALSE)
+        return std::nullopt;
+
+    GLsizei length;
+    glGetProgramiv(shader_id, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> error_message;
+    error_message.resize(static_cast<size_t>(length));
+    glGetProgramInfoLog(shader_id, length, nullptr, error_message.data());
+    return std::format("Shader Linking failed:\n{}", error_message.data());
+}
+
+/// GL_COMPLETION_STATUS_KHR, from KHR_parallel_shader_compile (which our glad doesn't know about). ARB_parallel_shader_compile uses the same value.
+static constexpr GLenum completion_status{0x91B1};
+
+/// With KHR_parallel_shader_compile, glCompileShader() and glLinkProgram() return immediately and the driver compiles on background threads.
+/// (Without it, they still return immediately on most drivers, but then the first query of the result blocks until everything is done.)
+static auto parallel_compilation_is_supported() -> bool
+{
+    static bool const is_supported = []() {
+        bool const khr = glfwExtensionSupported("GL_KHR_parallel_shader_compile") == GLFW_TRUE;
+        if (!khr && glfwExtensionSupported("GL_ARB_parallel_shader_compile") == GLFW_FALSE)
+            return false;
+        // NOLINTNEXTLINE(*reinterpret-cast)
+        auto const max_shader_compiler_threads = reinterpret_cast<void(APIENTRYP)(GLuint)>(glfwGetProcAddress(khr ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB"));
+        if (max_shader_compiler_threads)
+            max_shader_compiler_threads(0xFFFFFFFF); // Let the driver use as many threads as it wants
+        return true;
+    }();
+    return is_supported;
+}
+
+/// Never blocks if the driver supports parallel compilation. Otherwise always returns true, and checking the result will block.
+static auto compilation_is_completed(GLuint program) -> bool
+{
+    if (!parallel_compilation_is_supported())
+        return true;
+    GLint is_completed{};
+    glGetProgramiv(program, completion_status, &is_completed);
+    return is_completed != GL_FALSE;
+}
+
+/// Reads and preprocesses the source of each stage.
+/// @param files If not null, receives the paths of all the files used by the shader.
+static auto get_source_codes(std::span<internal::ShaderStage const> stages, std::span<ShaderDefine const> defines, std::vector<std::filesystem::path>* files) -> std::vector<std::string>
+{
+    auto source_codes = std::vector<std::string>{};
+    for (auto const& stage : stages)
+        source_codes.push_back(std::visit([&](auto&& source) { return get_source_code(source, defines, files); }, stage.source));
+    return source_codes;
+}
+
+/// Loads program from the binary cache if possible (and then returns std::nullopt). Otherwise starts compiling and linking it.
+static auto submit_compilation(GLuint program, std::span<internal::ShaderStage const> stages, std::vector<std::string> source_codes) -> std::optional<internal::PendingShaderProgram>
+{
+    auto const cache_key = ShaderBinaryCache::make_key(std::vector<std::string_view>{source_codes.begin(), source_codes.end()});
+    if (ShaderBinaryCache::load(program, cache_key))
+        return std::nullopt;
+
+    parallel_compilation_is_supported(); // Makes sure the driver's compiler threads are enabled before we submit any work
+    auto pending = internal::PendingShaderProgram{
+        .modules      = {},
+        .source_codes = std::move(source_codes),
+        .cache_key    = cache_key,
+    };
+    // Everything is submitted without querying any result, so that the driver can do all the work in the background
+    for (size_t i = 0; i < stages.size(); ++i)
     {
-        glDeleteShader(_id);
+        auto const& module = pending.modules.emplace_back(stages[i].kind);
+        compile_shader_module(module.id(), pending.source_codes[i]);
+        glAttachShader(program, module.id());
     }
-    UniqueShaderModule(UniqueShaderModule const&)                    = delete;
-    auto operator=(UniqueShaderModule const&) -> UniqueShaderModule& = delete;
-    UniqueShaderModule(UniqueShaderModule&& o) noexcept
-        : _id{o._id}
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    return pending;
+}
+
+/// Blocks until the compilation is done (unless compilation_is_completed()), and returns the error if it failed.
+static auto compilation_result(GLuint program, internal::PendingShaderProgram const& pending) -> std::optional<std::string>
+{
+    for (auto const& module : pending.modules)
+        glDetachShader(program, module.id());
+    for (size_t i = 0; i < pending.modules.size(); ++i)
     {
-        o._id = 0;
+        if (auto error = compilation_error(pending.modules[i].id(), pending.source_codes[i]))
+            return error;
     }
-    auto operator=(UniqueShaderModule&& o) noexcept -> UniqueShaderModule&
+    if (auto error = linking_error(program))
+        return error;
+    ShaderBinaryCache::save(program, pending.cache_key);
+    return std::nullopt;
+}
+
+Shader::Shader(Shader_Descriptor const& desc)
+    : Shader{{{GL_VERTEX_SHADER, desc.vertex}, {GL_FRAGMENT_SHADER, desc.fragment}}, desc.defines, desc.hot_reload, true}
+{}
+
+auto Shader::create_async(Shader_Descriptor const& desc) -> Shader
+{
+    return Shader{{{GL_VERTEX_SHADER, desc.vertex}, {GL_FRAGMENT_SHADER, desc.fragment}}, desc.defines, desc.hot_reload, false};
+}
+
+Shader::Shader(std::vector<internal::ShaderStage> stages, std::vector<ShaderDefine> defines, bool hot_reload, bool wait_until_ready)
+{
+    auto files = std::vector<std::filesystem::path>{};
+    _pending   = submit_compilation(id(), stages, get_source_codes(stages, defines, hot_reload ? &files : nullptr));
+    if (hot_reload)
     {
-        if (&o != this)
-        {
-            glDeleteShader(_id);
-            _id   = o._id;
-            o._id = 0;
-        }
-        return *this;
+        auto& state = _hot_reload.emplace(internal::ShaderHotReload{.stages = std::move(stages), .defines = std::move(defines)});
+        for (auto const& file : files)
+            state.watcher.watch(file);
     }
 
-    auto id() const { return _id; }
+    if (wait_until_ready)
+        this->wait_until_ready();
+}
 
-private:
-    GLuint _id;
-};
+auto Shader::is_ready() const -> bool
+{
+    if (_pending && !compilation_is_completed(id()))
+        return false;
+    wait_until_ready();
+    return true;
+}
 
-void check_for_linking_errors(GLuint shader_id)
+void Shader::wait_until_ready() const
 {
-    int result;
-    glGetProgramiv(shader_id, GL_LINK_STATUS, &result);
-    if (result == GL_FALSE)
+    if (!_pending)
+        return;
+    // Moved out first so that the modules get deleted, and we don't check the errors twice, even if handle_error() throws
+    auto const pending = std::move(*_pending);
+    _pending.reset();
+    if (auto const error = compilation_result(id(), pending))
+        handle_error(*error);
+}
+
+void Shader::start_hot_reload() const
+{
+    auto& hot_reload = *_hot_reload;
+    try
     {
-        GLsizei length;
-        glGetProgramiv(shader_id, GL_INFO_LOG_LENGTH, &length);
-        std::vector<GLchar> error_message;
-        error_message.resize(static_cast<size_t>(length));
-        glGetProgramInfoLog(shader_id, length, nullptr, error_message.data());
-        handle_error(std::format("Shader Linking failed:\n{}", error_message.data()));
+        auto files        = std::vector<std::filesystem::path>{};
+        auto source_codes = get_source_codes(hot_reload.stages, hot_reload.defines, &files);
+        // The includes might have changed
+        hot_reload.watcher.clear();
+        for (auto const& file : files)
+            hot_reload.watcher.watch(file);
+
+        // Replaces the reload that was in progress, if any: it is outdated anyway
+        hot_reload.program.emplace();
+        hot_reload.pending = submit_compilation(hot_reload.program->id(), hot_reload.stages, std::move(source_codes));
+    }
+    catch (std::exception const& e) // e.g. an included file that doesn't exist. Reported by update_hot_reload() instead, because we don't want to crash while editing the shader.
+    {
+        hot_reload.program.reset();
+        hot_reload.pending.reset();
+        hot_reload.error = e.what();
     }
 }
 
-Shader::Shader(Shader_Descriptor const& desc)
+void Shader::update_hot_reload() const
+{
+    if (!_hot_reload)
+        return;
+    auto& hot_reload = *_hot_reload;
+    if (hot_reload.watcher.has_changed())
+        start_hot_reload();
+    if (!hot_reload.program || (hot_reload.pending && !compilation_is_completed(hot_reload.program->id())))
+        return;
+
+    auto program = std::move(*hot_reload.program);
+    hot_reload.program.reset();
+    if (hot_reload.pending)
+    {
+        auto const pending = std::move(*hot_reload.pending);
+        hot_reload.pending.reset();
+        if (auto error = compilation_result(program.id(), pending))
+        {
+            hot_reload.error = std::move(*error); // We keep using the previous version of the shader
+            return;
+        }
+    }
+    // Only swapped once we know the new program works
+    _id = std::move(program);
+    _uniform_locations.clear();
+    _storage_block_bindings.clear();
+    hot_reload.error.clear();
+}
+
+auto Shader::hot_reload_error() const -> std::string_view
 {
-    auto vertex_shader   = UniqueShaderModule{GL_VERTEX_SHADER, desc.vertex};
-    auto fragment_shader = UniqueShaderModule{GL_FRAGMENT_SHADER, desc.fragment};
-    glAttachShader(id(), vertex_shader.id());
-    glAttachShader(id(), fragment_shader.id());
-    glLinkProgram(id());
-    glDetachShader(id(), fragment_shader.id());
-    glDetachShader(id(), vertex_shader.id());
-    check_for_linking_errors(id());
+    return _hot_reload ? std::string_view{_hot_reload->error} : std::string_view{};
 }
 
 static void assert_shader_is_bound(GLuint id)
@@ -112,7 +252,9 @@ static void assert_shader_is_bound(GLuint id)
 
 void Shader::bind() const
 {
-    glUseProgram(id());
+    wait_until_ready();
+    update_hot_reload();
+    GLState::use_program(id());
 }
 
 auto Shader::uniform_location(std::string_view uniform_name) const -> GLint
@@ -138,7 +280,8 @@ void Shader::set_uniform(std::string_view uniform_name, int v) const
 }
 void Shader::set_uniform(std::string_view uniform_name, unsigned int v) const
 {
-    set_uniform(uniform_name, static_cast<int>(v));
+    assert_shader_is_bound(id());
+    glUniform1ui(uniform_location(uniform_name), v); // A uint uniform can't be set with glUniform1i (that's a GL_INVALID_OPERATION)
 }
 void Shader::set_uniform(std::string_view uniform_name, bool v) const
 {
@@ -216,10 +359,45 @@ static auto get_next_texture_slot() -> GLuint
 void Shader::set_uniform(std::string_view uniform_name, Texture const& texture) const
 {
     auto const slot = get_next_texture_slot();
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, texture.id());
-    set_uniform(uniform_name, slot);
-    glActiveTexture(GL_TEXTURE0); // HACK Slot 0 is used for texture operations like resizing and setting the image, anyone might override the texture set here at any time. So we use all slots but the 0th one for rendering.
+    GLState::bind_texture(slot, texture.id());
+    set_uniform(uniform_name, static_cast<int>(slot)); // Samplers can only be set with glUniform1i
+}
+
+static auto get_next_image_unit() -> GLuint
+{
+    static GLuint       current_unit = 0;
+    static GLuint const max_units    = []() {
+        GLint res{};
+        glGetIntegerv(GL_MAX_IMAGE_UNITS, &res);
+        return static_cast<GLuint>(res);
+    }();
+
+    current_unit = (current_unit + 1) % max_units;
+    return current_unit;
+}
+
+void Shader::set_image(std::string_view uniform_name, Texture const& texture, InternalFormatSized format, ImageAccess access, GLint level) const
+{
+    auto const unit = get_next_image_unit();
+    glBindImageTexture(unit, texture.id(), level, GL_FALSE, 0, static_cast<GLenum>(access), static_cast<GLenum>(format));
+    set_uniform(uniform_name, static_cast<int>(unit)); // Images can only be set with glUniform1i
+}
+
+void Shader::set_storage_buffer(std::string_view block_name, StorageBuffer const& buffer) const
+{
+    assert_shader_is_bound(id());
+    auto const name = std::string{block_name};
+    auto       it   = _storage_block_bindings.find(name);
+    if (it == _storage_block_bindings.end())
+    {
+        // Each block of the program gets its own binding point: its index
+        GLuint const index = glGetProgramResourceIndex(id(), GL_SHADER_STORAGE_BLOCK, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glShaderStorageBlockBinding(id(), index, index);
+        it = _storage_block_bindings.emplace(name, index).first;
+    }
+    if (it->second != GL_INVALID_INDEX) // Like uniforms, blocks that are not used by the shader are silently ignored
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, it->second, buffer.id());
 }
 
 // void Shader::set_uniform_texture(std::string_view uniform_name, GLuint texture_id, TextureSamplerDescriptor const& sampler) const
@@ -1,11 +1,17 @@
 #pragma once
+#include <cstdint>
 #include <filesystem>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <variant>
 #include <vector>
 #include <format>
+#include "FileWatcher.hpp"
+#include "ShaderBinaryCache.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "StorageBuffer.hpp"
 #include "Texture.hpp"
 #include <glad/glad.h>
 #include "glm/glm.hpp"
@@ -43,6 +49,46 @@ public:
 private:
     GLuint _id;
 };
+
+class UniqueShaderModule {
+public:
+    explicit UniqueShaderModule(GLenum shader_kind)
+        : _id{glCreateShader(shader_kind)}
+    {}
+    ~UniqueShaderModule()
+    {
+        glDeleteShader(_id);
+    }
+    UniqueShaderModule(UniqueShaderModule const&)                    = delete; // You cannot copy
+    auto operator=(UniqueShaderModule const&) -> UniqueShaderModule& = delete; // a shader module. But you can move it
+    UniqueShaderModule(UniqueShaderModule&& o) noexcept
+        : _id{o._id}
+    {
+        o._id = 0;
+    }
+    auto operator=(UniqueShaderModule&& o) noexcept -> UniqueShaderModule&
+    {
+        if (&o != this)
+        {
+            glDeleteShader(_id);
+            _id   = o._id;
+            o._id = 0;
+        }
+        return *this;
+    }
+
+    auto id() const { return _id; }
+
+private:
+    GLuint _id;
+};
+
+/// What we need to keep around while the driver compiles and links a program in the background
+struct PendingShaderProgram {
+    std::vector<UniqueShaderModule> modules;
+    std::vector<std::string>        source_codes; // One per module
+    ShaderBinaryCache::Key          cache_key;
+};
 } // namespace internal
 
 namespace ShaderSource {
@@ -58,18 +104,64 @@ using AnyShaderSource = std::variant<
     ShaderSource::File,
     ShaderSource::Code>;
 
+/// The sources can #include other files, see preprocess_shader().
 struct Shader_Descriptor {
-    AnyShaderSource vertex{};
-    AnyShaderSource fragment{};
+    AnyShaderSource           vertex{};
+    AnyShaderSource           fragment{};
+    std::vector<ShaderDefine> defines{};         // Added to both the vertex and the fragment shader
+    bool                      hot_reload{false}; // Recompiles the shader in the background when one of its files (or a file they include) is modified. See Shader::hot_reload_error(). The files are then always read from the disk, even if assets.pak contains them.
+};
+
+namespace internal {
+struct ShaderStage {
+    GLenum          kind; // GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_COMPUTE_SHADER, etc.
+    AnyShaderSource source;
+};
+
+struct ShaderHotReload {
+    std::vector<ShaderStage>            stages;
+    std::vector<ShaderDefine>           defines;
+    FileWatcher                         watcher{};
+    std::optional<UniqueShader>         program{}; // The new version of the program, that will replace the current one once it has linked successfully
+    std::optional<PendingShaderProgram> pending{};
+    std::string                         error{};
+};
+} // namespace internal
+
+enum class ImageAccess : GLenum {
+    ReadOnly  = GL_READ_ONLY,
+    WriteOnly = GL_WRITE_ONLY,
+    ReadWrite = GL_READ_WRITE,
 };
 
 class Shader {
 public:
+    /// Compiles and links the shader, and waits until it is done.
     explicit Shader(Shader_Descriptor const&);
+    /// Submits the compilation and linking of the shader, and returns without waiting for them.
+    /// Create all your shaders with this first, and then wait for them: drivers that support KHR_parallel_shader_compile will compile them all at the same time on background threads.
+    /// On other drivers this still works, the shader is just compiled when you first wait for it.
+    static auto create_async(Shader_Descriptor const&) -> Shader;
+
+    /// Returns true once the shader is compiled and linked, without ever blocking (if the driver supports KHR_parallel_shader_compile).
+    /// Calls handle_error() if the compilation failed.
+    auto is_ready() const -> bool;
+    /// Blocks until the shader is compiled and linked. bind() does it for you.
+    /// Calls handle_error() if the compilation failed.
+    void wait_until_ready() const;
+
+    /// The error of the last attempt to hot-reload the shader, or an empty string if it succeeded (or if hot reload is disabled).
+    /// While there is an error, the shader keeps using the last version that compiled successfully.
+    auto hot_reload_error() const -> std::string_view;
 
     auto id() const -> GLuint { return _id.id(); }
 
+    /// Also checks if the files have been modified and swaps in the new version of the shader once it is ready, if hot_reload is enabled.
     void bind() const;
+    /// Binds level of texture to an image unit, for imageLoad() / imageStore(). format must be the format of the texture, and match the layout qualifier of the image in the shader.
+    void set_image(std::string_view uniform_name, Texture const& texture, InternalFormatSized format, ImageAccess access, GLint level = 0) const;
+    /// Binds buffer to the shader storage block called block_name (the name of the block, not of its instance).
+    void set_storage_buffer(std::string_view block_name, StorageBuffer const& buffer) const;
     void set_uniform(std::string_view uniform_name, int) const;
     void set_uniform(std::string_view uniform_name, unsigned int) const;
     void set_uniform(std::string_view uniform_name, bool) const;
@@ -85,10 +177,18 @@ public:
     void set_uniform(std::string_view uniform_name, glm::mat4 const&) const;
     void set_uniform(std::string_view uniform_name, Texture const&) const;
 
+protected:
+    Shader(std::vector<internal::ShaderStage> stages, std::vector<ShaderDefine> defines, bool hot_reload, bool wait_until_ready);
+
 private:
+    void start_hot_reload() const;
+    void update_hot_reload() const;
     auto uniform_location(std::string_view uniform_name) const -> GLint;
 
 private:
-    internal::UniqueShader                         _id{};
-    mutable std::unordered_map<std::string, GLint> _uniform_locations{};
+    mutable internal::UniqueShader                        _id{}; // Mutable because hot reload can replace it
+    mutable std::optional<internal::PendingShaderProgram> _pending{}; // Empty once the compilation is finished
+    mutable std::optional<internal::ShaderHotReload>      _hot_reload{};
+    mutable std::unordered_map<std::string, GLint>        _uniform_locations{};
+    mutable std::unordered_map<std::string, GLuint>       _storage_block_bindings{};
 };
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "ShaderBinaryCache.hpp"
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <random>
+#include <system_error>
+#include <vector>
+#include <exe_path/exe_path.h>
+#include "fnv1a.hpp"
+
+namespace ShaderBinaryCache {
+
+static auto cache_folder() -> std::filesystem::path
+{
+    return exe_path::user_data() / "TPRendering" / "shader_cache";
+}
+
+static auto cache_file(Key const& key) -> std::filesystem::path
+{
+    return cache_folder() / std::format("{:016x}.bin", key.hash);
+}
+
+/// Different for each call, and for each instance of the app
+static auto unique_id() -> uint64_t
+{
+    auto random = std::random_device{};
+    return (static_cast<uint64_t>(random()) << 32) ^ random();
+}
+
+static auto gl_string(GLenum name) -> std::string_view
+{
+    auto const* const str = reinterpret_cast<char const*>(glGetString(name)); // NOLINT(*reinterpret-cast)
+    return str ? std::string_view{str} : std::string_view{};
+}
+
+static auto is_supported() -> bool
+{
+    GLint formats_count{};
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats_count);
+    return formats_count > 0;
+}
+
+static auto hash_program(std::span<std::string_view const> source_codes, uint64_t seed) -> uint64_t
+{
+    auto hash = fnv1a(gl_string(GL_VENDOR), seed);
+    hash      = fnv1a(gl_string(GL_RENDERER), hash);
+    hash      = fnv1a(gl_string(GL_VERSION), hash);
+    for (auto const& code : source_codes)
+    {
+        hash = fnv1a(std::string_view{"\0", 1}, hash); // Separates the strings, so that ("ab", "c") and ("a", "bc") have different keys
+        hash = fnv1a(code, hash);
+    }
+    return hash;
+}
+
+auto make_key(std::span<std::string_view const> source_codes) -> Key
+{
+    return Key{
+        .hash  = hash_program(source_codes, fnv1a("")),
+        .check = hash_program(source_codes, fnv1a("ShaderBinaryCache check")),
+    };
+}
+
+// The file contains key.check, the binary format (a GLenum), and then the binary itself.
+auto load(GLuint program, Key const& key) -> bool
+{
+    if (!is_supported())
+        return false;
+    auto ifs = std::ifstream{cache_file(key), std::ios::binary};
+    if (!ifs)
+        return false;
+    uint64_t check{};
+    GLenum   format{};
+    ifs.read(reinterpret_cast<char*>(&check), sizeof(check));   // NOLINT(*reinterpret-cast)
+    ifs.read(reinterpret_cast<char*>(&format), sizeof(format)); // NOLINT(*reinterpret-cast)
+    if (!ifs || check != key.check) // Truncated file, or another program whose hash collides with ours
+        return false;
+    auto binary = std::vector<char>{std::istreambuf_iterator<char>{ifs}, {}};
+    if (binary.empty())
+        return false;
+
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success{};
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success == GL_FALSE) // The driver has changed in a way that the version string doesn't tell, or the file is corrupted
+    {
+        std::error_code ignored;
+        std::filesystem::remove(cache_file(key), ignored);
+        return false;
+    }
+    return true;
+}
+
+void save(GLuint program, Key const& key)
+{
+    if (!is_supported())
+        return;
+    GLint length{};
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    auto   binary = std::vector<char>(static_cast<size_t>(length));
+    GLenum format{};
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(cache_folder(), error);
+    if (error)
+        return;
+    // Written to a temporary file first, so that another instance of the app never reads a partially written binary.
+    // Its name is unique, so that two instances saving the same program at the same time don't write into the same temporary file.
+    auto const path           = cache_file(key);
+    auto       temporary_path = path;
+    temporary_path += std::format(".{:016x}.tmp", unique_id());
+    bool success{};
+    {
+        auto ofs = std::ofstream{temporary_path, std::ios::binary};
+        ofs.write(reinterpret_cast<char const*>(&key.check), sizeof(key.check)); // NOLINT(*reinterpret-cast)
+        ofs.write(reinterpret_cast<char const*>(&format), sizeof(format));       // NOLINT(*reinterpret-cast)
+        ofs.write(binary.data(), length);
+        success = static_cast<bool>(ofs);
+    }
+    if (success)
+        std::filesystem::rename(temporary_path, path, error);
+    if (!success || error)
+        std::filesystem::remove(temporary_path, error);
+}
+
+} // namespace ShaderBinaryCache
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <glad/glad.h>
+
+/// Caches linked programs on disk (in exe_path::user_data()), so that we don't have to compile the shaders again at the next launch.
+/// The binaries are only valid for the exact driver that produced them, so the key also depends on the vendor, renderer and version of the driver.
+namespace ShaderBinaryCache {
+
+/// Identifies a program: two hashes of all of its source codes (with their defines already inserted) and the driver strings.
+struct Key {
+    uint64_t hash;  /// Names the file of the binary
+    uint64_t check; /// Computed with another seed and stored in the file, so that two programs whose hash collide don't load each other's binary
+};
+
+auto make_key(std::span<std::string_view const> source_codes) -> Key;
+
+/// Returns false if there is no binary for this key, or if the driver refused it (e.g. after a driver update). You must then compile the program normally.
+/// Returns true if program is now linked and ready to use.
+auto load(GLuint program, Key const& key) -> bool;
+
+/// Stores the binary of program, which must have been successfully linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set to GL_TRUE.
+/// Failing to write the cache is not an error: we will just compile again at the next launch.
+void save(GLuint program, Key const& key);
+
+} // namespace ShaderBinaryCache
@@ -0,0 +1,46 @@
+#include "ShaderPermutations.hpp"
+#include <algorithm>
+
+/// The same set of defines always gives the same key, whatever their order
+static auto permutation_key(std::vector<ShaderDefine> defines) -> std::string
+{
+    std::sort(defines.begin(), defines.end(), [](ShaderDefine const& a, ShaderDefine const& b) { return a.name < b.name; });
+    auto key = std::string{};
+    for (auto const& define : defines)
+    {
+        key += define.name;
+        key += '=';
+        key += define.value;
+        key += '\n'; // Can't appear in a define, so the key is unambiguous
+    }
+    return key;
+}
+
+ShaderPermutations::ShaderPermutations(Shader_Descriptor base)
+    : _base{std::move(base)}
+{}
+
+auto ShaderPermutations::find_or_create(std::vector<ShaderDefine> const& defines) -> Shader const&
+{
+    auto key = permutation_key(defines);
+    auto it  = _shaders.find(key);
+    if (it == _shaders.end())
+    {
+        auto desc = _base;
+        desc.defines.insert(desc.defines.end(), defines.begin(), defines.end());
+        it = _shaders.emplace(std::move(key), Shader::create_async(desc)).first;
+    }
+    return it->second;
+}
+
+auto ShaderPermutations::get(std::vector<ShaderDefine> const& defines) -> Shader const&
+{
+    auto const& shader = find_or_create(defines);
+    shader.wait_until_ready();
+    return shader;
+}
+
+void ShaderPermutations::prepare(std::vector<ShaderDefine> const& defines)
+{
+    find_or_create(defines);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Shader.hpp"
+
+/// Variants of the same shader that only differ by their defines, e.g. to remove from the hot loop of a shader the branches of the features that are disabled.
+/// Each permutation is compiled the first time it is requested, and then kept for the lifetime of the ShaderPermutations.
+class ShaderPermutations {
+public:
+    explicit ShaderPermutations(Shader_Descriptor base);
+
+    /// defines are added to the ones of the base descriptor. Their order doesn't matter.
+    /// The returned reference stays valid as long as the ShaderPermutations is alive.
+    auto get(std::vector<ShaderDefine> const& defines) -> Shader const&;
+
+    /// Starts compiling a permutation in the background (see Shader::create_async()), so that a later get() doesn't have to wait as long.
+    void prepare(std::vector<ShaderDefine> const& defines);
+
+    auto permutations_count() const -> size_t { return _shaders.size(); }
+
+private:
+    auto find_or_create(std::vector<ShaderDefine> const& defines) -> Shader const&;
+
+private:
+    Shader_Descriptor                       _base;
+    std::unordered_map<std::string, Shader> _shaders{};
+};
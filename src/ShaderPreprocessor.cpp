@@ -0,0 +1,123 @@
+#include "ShaderPreprocessor.hpp"
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <vector>
+#include "AssetArchive.hpp"
+#include "handle_error.hpp"
+
+namespace {
+struct Context {
+    std::vector<std::string> included_files{}; // The index of a file is its source string number in the #line directives
+    std::string              output{};
+    bool                     read_loose_files{false}; // The files are watched for hot reload, so we must read the ones on disk, not the ones in assets.pak
+};
+} // namespace
+
+static auto trim_start(std::string_view str) -> std::string_view
+{
+    auto const begin = str.find_first_not_of(" \t");
+    return begin == std::string_view::npos ? std::string_view{} : str.substr(begin);
+}
+
+/// Returns the path in `#include "path"`, or std::nullopt if the line is not an #include directive
+static auto included_path(std::string_view line, std::string_view file_name, size_t line_number) -> std::optional<std::string_view>
+{
+    line = trim_start(line);
+    if (!line.starts_with('#'))
+        return std::nullopt;
+    line = trim_start(line.substr(1));
+    if (!line.starts_with("include"))
+        return std::nullopt;
+    line             = trim_start(line.substr(std::string_view{"include"}.size()));
+    auto const close = line.size() > 1 ? line.find('"', 1) : std::string_view::npos;
+    if (!line.starts_with('"') || close == std::string_view::npos)
+        handle_error(std::format("Invalid #include in {} at line {}: expected #include \"path\".", file_name, line_number));
+    return line.substr(1, close - 1);
+}
+
+static auto is_version_directive(std::string_view line) -> bool
+{
+    line = trim_start(line);
+    return line.starts_with('#') && trim_start(line.substr(1)).starts_with("version");
+}
+
+static void append_line_directive(Context& context, size_t line_number, size_t source_index)
+{
+    context.output += std::format("#line {} {}\n", line_number, source_index);
+}
+
+static void preprocess(Context& context, std::string_view code, std::filesystem::path const& file_path, std::span<ShaderDefine const> defines)
+{
+    auto const source_index = context.included_files.size();
+    auto const file_name    = file_path.empty() ? std::string{"<code>"} : file_path.generic_string();
+    context.included_files.push_back(file_path.lexically_normal().generic_string());
+    if (source_index != 0)
+    {
+        context.output += std::format("// Source {} is {}\n", source_index, file_name);
+        append_line_directive(context, 1, source_index);
+    }
+
+    bool       defines_inserted = source_index != 0; // Only the root file gets the defines
+    size_t     line_number      = 0;
+    auto const insert_defines   = [&]() {
+        for (auto const& define : defines)
+            context.output += define.value.empty()
+                                  ? std::format("#define {}\n", define.name)
+                                  : std::format("#define {} {}\n", define.name, define.value);
+        defines_inserted = true;
+    };
+
+    while (!code.empty())
+    {
+        auto const end  = code.find('\n');
+        auto const line = code.substr(0, end);
+        code            = end == std::string_view::npos ? std::string_view{} : code.substr(end + 1);
+        ++line_number;
+
+        if (!defines_inserted && !is_version_directive(line) && !trim_start(line).empty() && !trim_start(line).starts_with("//"))
+        { // There is no #version directive
+            insert_defines();
+            append_line_directive(context, line_number, source_index);
+        }
+
+        if (auto const include = included_path(line, file_name, line_number))
+        {
+            auto const path = (file_path.parent_path() / *include).lexically_normal();
+            if (std::find(context.included_files.begin(), context.included_files.end(), path.generic_string()) == context.included_files.end())
+            {
+                auto const included_code = context.read_loose_files ? read_loose_asset(path) : read_asset(path);
+                preprocess(context, included_code.as_string_view(), path, {});
+            }
+            append_line_directive(context, line_number + 1, source_index);
+            continue;
+        }
+
+        context.output += line;
+        context.output += '\n';
+        if (!defines_inserted && is_version_directive(line))
+        {
+            insert_defines();
+            append_line_directive(context, line_number + 1, source_index);
+        }
+    }
+    if (!defines_inserted)
+        insert_defines();
+}
+
+auto preprocess_shader(std::string_view code, std::filesystem::path const& file_path, std::span<ShaderDefine const> defines, std::vector<std::filesystem::path>* files) -> std::string
+{
+    auto context             = Context{};
+    context.read_loose_files = files != nullptr;
+    context.output.reserve(code.size());
+    preprocess(context, code, file_path, defines);
+    if (files)
+    {
+        for (auto const& file : context.included_files)
+        {
+            if (!file.empty()) // Code that doesn't come from a file
+                files->emplace_back(file);
+        }
+    }
+    return std::move(context.output);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ShaderDefine {
+    std::string name;
+    std::string value{};
+};
+
+/// Resolves the #include "path" directives of a GLSL source, and inserts "#define name value" for each define right after the #version line.
+/// Included paths are relative to the file that includes them (or to the folder of the executable for code that doesn't come from a file, i.e. when file_path is empty).
+/// Each file is only included once per shader, even if several files include it, so you don't need include guards.
+/// #line directives are inserted so that compilation errors still report the right line. The number of the source string is the index of the file in the order in which it was first included, and the code contains a comment telling which file each number is.
+/// Calls handle_error() if an included file can't be found, or if a #include directive is malformed.
+/// @param files If not null, the paths of all the files that the code depends on (file_path and everything it includes) are appended to it.
+///              The included files are then read from the disk even if assets.pak contains them (see read_loose_asset()), since these are the files that you will watch.
+auto preprocess_shader(std::string_view code, std::filesystem::path const& file_path, std::span<ShaderDefine const> defines, std::vector<std::filesystem::path>* files = nullptr) -> std::string;
@@ -0,0 +1,28 @@
+#include "StorageBuffer.hpp"
+#include <cassert>
+
+StorageBuffer::StorageBuffer(size_t size_in_bytes)
+    : _size_in_bytes{size_in_bytes}
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id());
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(size_in_bytes), nullptr, GL_DYNAMIC_COPY);
+    GLubyte const zero{0};
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R8UI, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void StorageBuffer::upload(std::span<std::byte const> data, size_t offset_in_bytes)
+{
+    assert(offset_in_bytes + data.size() <= _size_in_bytes && "Trying to upload past the end of the StorageBuffer.");
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id());
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(offset_in_bytes), static_cast<GLsizeiptr>(data.size()), data.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void StorageBuffer::download(std::span<std::byte> data, size_t offset_in_bytes) const
+{
+    assert(offset_in_bytes + data.size() <= _size_in_bytes && "Trying to download past the end of the StorageBuffer.");
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id());
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(offset_in_bytes), static_cast<GLsizeiptr>(data.size()), data.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include "Buffer.hpp"
+#include <glad/glad.h>
+
+/// A buffer that shaders can read and write (a Shader Storage Buffer Object). See Shader::set_storage_buffer().
+/// You cannot copy a StorageBuffer. But you can move it.
+class StorageBuffer {
+public:
+    /// Allocates size_in_bytes bytes, filled with zeros.
+    explicit StorageBuffer(size_t size_in_bytes);
+    /// Allocates a buffer with the size of data, and fills it with data.
+    template<typename T>
+    explicit StorageBuffer(std::span<T const> data)
+        : StorageBuffer{data.size_bytes()}
+    {
+        upload(data);
+    }
+
+    auto id() const -> GLuint { return _id.id(); }
+    auto size_in_bytes() const -> size_t { return _size_in_bytes; }
+
+    /// Writes data at offset_in_bytes in the buffer.
+    void upload(std::span<std::byte const> data, size_t offset_in_bytes = 0);
+    template<typename T>
+    void upload(std::span<T const> data, size_t offset_in_bytes = 0)
+    {
+        upload(std::as_bytes(data), offset_in_bytes);
+    }
+
+    /// Reads the buffer back into data, starting at offset_in_bytes. This waits for the GPU to finish writing to the buffer, so avoid doing it every frame.
+    /// Don't forget to call memory_barrier(Barrier::BufferUpdate) after the shader that wrote to the buffer.
+    void download(std::span<std::byte> data, size_t offset_in_bytes = 0) const;
+    template<typename T>
+    void download(std::span<T> data, size_t offset_in_bytes = 0) const
+    {
+        download(std::as_writable_bytes(data), offset_in_bytes);
+    }
+
+private:
+    internal::UniqueBuffer _id{};
+    size_t                 _size_in_bytes{};
+};
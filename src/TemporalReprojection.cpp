@@ -0,0 +1,59 @@
+#include "TemporalReprojection.hpp"
+#include <cassert>
+#include "PostProcessGraph.hpp"
+
+TemporalReprojection::TemporalReprojection(TemporalReprojection_Descriptor const& desc)
+    : _desc{desc}
+    , _shader{Shader::create_async({
+          .vertex   = ShaderSource::File{"res/fullscreen.vert"},
+          .fragment = ShaderSource::File{"res/temporal_reprojection.frag"},
+      })}
+{}
+
+void TemporalReprojection::apply(Texture const& current_samples, Texture const& primary_hits, RayTracingCamera const& camera, glm::ivec2 size)
+{
+    if (size != _size || !_history[0])
+    {
+        _size = size;
+        for (auto& history : _history)
+        {
+            history.emplace(RenderTarget_Descriptor{
+                .width          = size.x,
+                .height         = size.y,
+                .color_textures = {ColorAttachment_Descriptor{.format = InternalFormat_Color::RGBA32F}}, // The alpha counts the frames, it needs more precision than half floats
+            });
+        }
+        _previous_camera.reset();
+    }
+
+    auto const& previous_camera = _previous_camera.value_or(camera);
+    auto const& previous        = *_history[_current];
+    _current                    = 1 - _current;
+    _history[_current]->render([&]() {
+        _shader.bind();
+        _shader.set_uniform("currentSamples", current_samples);
+        _shader.set_uniform("primaryHits", primary_hits);
+        _shader.set_uniform("history", previous.color_texture(0));
+        _shader.set_uniform("resolution", glm::vec2{size});
+        _shader.set_uniform("previousCameraPosition", previous_camera.position);
+        _shader.set_uniform("previousCameraRotation", previous_camera.rotation);
+        _shader.set_uniform("previousZoom", previous_camera.zoom);
+        _shader.set_uniform("cameraMoved", previous_camera != camera);
+        _shader.set_uniform("maxHistoryLength", _desc.max_history_length);
+        _shader.set_uniform("clippingStrength", _desc.clipping_strength);
+        draw_fullscreen_triangle();
+    });
+    _previous_camera = camera;
+}
+
+auto TemporalReprojection::texture() const -> Texture const&
+{
+    assert(_history[_current].has_value() && "You must call apply() first.");
+    return _history[_current]->color_texture(0);
+}
+
+void TemporalReprojection::reset()
+{
+    _history = {};
+    _previous_camera.reset();
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <optional>
+#include "RenderTarget.hpp"
+#include "Shader.hpp"
+#include "Texture.hpp"
+#include "glm/glm.hpp"
+
+/// The camera of "res/default.frag", as given to its CameraPosition, CameraRotation and zoom uniforms.
+struct RayTracingCamera {
+    glm::vec3 position{};
+    glm::vec3 rotation{}; // In degrees
+    float     zoom{1.f};
+
+    auto operator==(RayTracingCamera const&) const -> bool = default;
+};
+
+struct TemporalReprojection_Descriptor {
+    float max_history_length{16.f}; // While the camera moves, the history weighs at most this many frames. Bigger values give less noise, but more ghosting.
+    float clipping_strength{1.5f};  // How far the history can be from the new samples around the pixel, in standard deviations. Smaller values reject more history, and give more noise.
+};
+
+/// Accumulates the samples of the progressive path tracer across frames, even while the camera moves.
+/// Instead of restarting from noise when the camera moves, the accumulated image is reprojected with the camera of the previous frame, so converged samples carry over.
+/// Render "res/default.frag" with the TEMPORAL_REPROJECTION define, into a target with two color attachments (RGBA16F for the samples, RGBA32F for the primary hits), then call apply().
+class TemporalReprojection {
+public:
+    explicit TemporalReprojection(TemporalReprojection_Descriptor const& = {});
+
+    /// current_samples and primary_hits are the FragColor and PrimaryHit outputs of default.frag, rendered with camera.
+    /// The history is cleared if the size changes.
+    void apply(Texture const& current_samples, Texture const& primary_hits, RayTracingCamera const& camera, glm::ivec2 size);
+
+    /// The accumulated image, after the last apply(). Its alpha is the number of frames it contains.
+    auto texture() const -> Texture const&;
+
+    /// Forgets the history, e.g. because the scene has changed.
+    void reset();
+
+private:
+    TemporalReprojection_Descriptor            _desc;
+    Shader                                     _shader;
+    std::array<std::optional<RenderTarget>, 2> _history{}; // We read from one while writing into the other
+    size_t                                     _current{0}; // Index of the one that contains the latest result
+    std::optional<RayTracingCamera>            _previous_camera{};
+    glm::ivec2                                 _size{0};
+};
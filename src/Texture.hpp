@@ -2,6 +2,7 @@
 #include <filesystem>
 #include <span>
 #include <variant>
+#include "GLState.hpp"
 #include <glad/glad.h>
 #include "glm/glm.hpp"
 
@@ -306,6 +307,7 @@ public:
     ~UniqueTexture()
     {
         glDeleteTextures(1, &_id);
+        GLState::forget_texture(_id);
     }
     UniqueTexture(UniqueTexture const&)                    = delete; // You cannot copy
     auto operator=(UniqueTexture const&) -> UniqueTexture& = delete; // a Texture. But you can move it, using std::move(my_texture)
@@ -319,6 +321,7 @@ public:
         if (&o != this)
         {
             glDeleteTextures(1, &_id);
+            GLState::forget_texture(_id);
             _id   = o._id;
             o._id = 0;
         }
@@ -350,6 +353,7 @@ struct EmptyImage {
     GLsizei             width{};
     GLsizei             height{};
     InternalFormatSized texture_format{InternalFormatSized::RGBA8};
+    GLsizei             levels_count{1}; /// Number of mipmap levels to allocate. Level 0 is the full-size image.
 };
 } // namespace TextureSource
 
@@ -0,0 +1,35 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t threads_count)
+{
+    for (size_t i = 0; i < threads_count; ++i)
+    {
+        _threads.emplace_back([this](std::stop_token const& stop_token) {
+            worker_loop(stop_token);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    for (auto& thread : _threads)
+        thread.request_stop();
+    _threads.clear(); // Joins the threads, once they have emptied the queue
+}
+
+void ThreadPool::worker_loop(std::stop_token const& stop_token)
+{
+    while (true)
+    {
+        auto job = std::function<void()>{};
+        {
+            auto lock = std::unique_lock{_mutex};
+            // When stop is requested we keep going until there are no jobs left
+            if (!_jobs_changed.wait(lock, stop_token, [&]() { return !_jobs.empty(); }))
+                return;
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        job();
+    }
+}
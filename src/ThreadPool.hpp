@@ -0,0 +1,50 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// A fixed set of threads that execute the jobs they are given, in the order they have been submitted.
+/// When the pool is destroyed, all the jobs that have already been submitted are run before the threads are joined.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads_count = std::max(std::thread::hardware_concurrency(), 1u));
+    ~ThreadPool();
+    ThreadPool(ThreadPool const&)                    = delete;
+    auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+    ThreadPool(ThreadPool&&)                         = delete;
+    auto operator=(ThreadPool&&) -> ThreadPool&      = delete;
+
+    /// Runs job on one of the threads of the pool.
+    /// The returned future gives you access to the value returned by the job, or rethrows the exception it has thrown.
+    template<typename Job>
+    auto submit(Job&& job) -> std::future<std::invoke_result_t<std::decay_t<Job>>>
+    {
+        // std::function must be copyable, which std::packaged_task isn't, so we share it
+        auto task   = std::make_shared<std::packaged_task<std::invoke_result_t<std::decay_t<Job>>()>>(std::forward<Job>(job));
+        auto future = task->get_future();
+        {
+            auto lock = std::unique_lock{_mutex};
+            _jobs.emplace_back([task]() { (*task)(); });
+        }
+        _jobs_changed.notify_one();
+        return future;
+    }
+
+    auto threads_count() const -> size_t { return _threads.size(); }
+
+private:
+    void worker_loop(std::stop_token const&);
+
+private:
+    std::mutex                        _mutex{};
+    std::condition_variable_any       _jobs_changed{};
+    std::deque<std::function<void()>> _jobs{};
+    std::vector<std::jthread>         _threads{}; // Must be declared last, so that the threads are stopped before the other members are destroyed
+};
@@ -0,0 +1,517 @@
+#include "VirtualTexture.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <unordered_set>
+#include "GLState.hpp"
+#include "handle_error.hpp"
+#include "make_absolute_path.hpp"
+
+static constexpr std::array<char, 4> vtex_magic{'V', 'T', 'E', 'X'};
+static constexpr uint32_t            vtex_version{1};
+
+namespace {
+struct MipLevel {
+    uint32_t             width{};
+    uint32_t             height{};
+    std::vector<uint8_t> texels{}; // RGBA8
+};
+} // namespace
+
+static auto downsample(MipLevel const& level) -> MipLevel
+{
+    auto res = MipLevel{
+        .width  = std::max(level.width / 2, 1u),
+        .height = std::max(level.height / 2, 1u),
+    };
+    res.texels.resize(static_cast<size_t>(res.width) * res.height * 4);
+    for (uint32_t y = 0; y < res.height; ++y)
+    {
+        for (uint32_t x = 0; x < res.width; ++x)
+        {
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                uint32_t sum = 0;
+                for (uint32_t dy = 0; dy < 2; ++dy)
+                {
+                    for (uint32_t dx = 0; dx < 2; ++dx)
+                    {
+                        auto const src_x = std::min(2 * x + dx, level.width - 1);
+                        auto const src_y = std::min(2 * y + dy, level.height - 1);
+                        sum += level.texels[(static_cast<size_t>(src_y) * level.width + src_x) * 4 + c];
+                    }
+                }
+                res.texels[(static_cast<size_t>(y) * res.width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return res;
+}
+
+void write_virtual_texture_file(img::Image const& image, std::filesystem::path const& file_path, uint32_t page_size, uint32_t border)
+{
+    assert(image.channels_count() == 4 && "write_virtual_texture_file() expects an RGBA image.");
+    assert(page_size > 0);
+
+    auto const pages_x = std::bit_ceil((image.width() + page_size - 1) / page_size);
+    auto const pages_y = std::bit_ceil((image.height() + page_size - 1) / page_size);
+    auto const header  = internal::VirtualTextureFileHeader{
+         .magic         = vtex_magic,
+         .version       = vtex_version,
+         .width         = image.width(),
+         .height        = image.height(),
+         .padded_width  = pages_x * page_size,
+         .padded_height = pages_y * page_size,
+         .page_size     = page_size,
+         .border        = border,
+         .levels_count  = static_cast<uint32_t>(std::bit_width(std::max(pages_x, pages_y))),
+    };
+
+    // Pad the image by repeating its last row and column, so that each level contains a whole number of pages
+    auto levels = std::vector<MipLevel>{};
+    levels.push_back({.width = header.padded_width, .height = header.padded_height});
+    levels[0].texels.resize(static_cast<size_t>(header.padded_width) * header.padded_height * 4);
+    for (uint32_t y = 0; y < header.padded_height; ++y)
+    {
+        auto const src_y = std::min(y, image.height() - 1);
+        for (uint32_t x = 0; x < header.padded_width; ++x)
+        {
+            auto const src_x = std::min(x, image.width() - 1);
+            std::copy_n(image.data() + (static_cast<size_t>(src_y) * image.width() + src_x) * 4, 4, levels[0].texels.data() + (static_cast<size_t>(y) * header.padded_width + x) * 4);
+        }
+    }
+    while (levels.size() < header.levels_count)
+        levels.push_back(downsample(levels.back()));
+
+    auto file = std::ofstream{file_path, std::ios::binary};
+    if (!file)
+        handle_error(std::format("[write_virtual_texture_file] Couldn't open \"{}\" for writing.", file_path.string()));
+
+    auto const padded_page_size = page_size + 2 * border;
+    auto const page_bytes_count = static_cast<uint64_t>(padded_page_size) * padded_page_size * 4;
+    auto       pages_count      = uint64_t{0};
+    for (uint32_t level = 0; level < header.levels_count; ++level)
+        pages_count += static_cast<uint64_t>(std::max(pages_x >> level, 1u)) * std::max(pages_y >> level, 1u);
+
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header)); // NOLINT(*reinterpret-cast)
+    auto const first_page_offset = sizeof(header) + pages_count * sizeof(uint64_t);
+    for (uint64_t i = 0; i < pages_count; ++i)
+    {
+        uint64_t const offset = first_page_offset + i * page_bytes_count;
+        file.write(reinterpret_cast<char const*>(&offset), sizeof(offset)); // NOLINT(*reinterpret-cast)
+    }
+
+    auto page = std::vector<uint8_t>(page_bytes_count);
+    for (uint32_t level = 0; level < header.levels_count; ++level)
+    {
+        auto const& mip = levels[level];
+        for (uint32_t page_y = 0; page_y < std::max(pages_y >> level, 1u); ++page_y)
+        {
+            for (uint32_t page_x = 0; page_x < std::max(pages_x >> level, 1u); ++page_x)
+            {
+                for (uint32_t y = 0; y < padded_page_size; ++y)
+                {
+                    auto const src_y = std::clamp(static_cast<int64_t>(page_y * page_size + y) - border, int64_t{0}, static_cast<int64_t>(mip.height) - 1);
+                    for (uint32_t x = 0; x < padded_page_size; ++x)
+                    {
+                        auto const src_x = std::clamp(static_cast<int64_t>(page_x * page_size + x) - border, int64_t{0}, static_cast<int64_t>(mip.width) - 1);
+                        std::copy_n(mip.texels.data() + (static_cast<size_t>(src_y) * mip.width + static_cast<size_t>(src_x)) * 4, 4, page.data() + (static_cast<size_t>(y) * padded_page_size + x) * 4);
+                    }
+                }
+                file.write(reinterpret_cast<char const*>(page.data()), static_cast<std::streamsize>(page.size())); // NOLINT(*reinterpret-cast)
+            }
+        }
+    }
+
+    if (!file)
+        handle_error(std::format("[write_virtual_texture_file] Failed to write to \"{}\".", file_path.string()));
+}
+
+static auto read_header(std::filesystem::path const& file_path) -> internal::VirtualTextureFileHeader
+{
+    auto header = internal::VirtualTextureFileHeader{};
+    auto file   = std::ifstream{file_path, std::ios::binary};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header)); // NOLINT(*reinterpret-cast)
+    if (!file || header.magic != vtex_magic)
+        handle_error(std::format("\"{}\" is not a virtual texture file. You can create one with write_virtual_texture_file().", file_path.string()));
+    if (header.version != vtex_version)
+        handle_error(std::format("\"{}\" has been created with an incompatible version of write_virtual_texture_file(). Please re-create it.", file_path.string()));
+    return header;
+}
+
+static auto pack_page_table_entry(uint32_t physical_x, uint32_t physical_y, uint32_t level) -> uint32_t
+{
+    return physical_x | (physical_y << 8) | (level << 16) | (1u << 24);
+}
+
+VirtualTexture::VirtualTexture(VirtualTexture_Descriptor const& desc)
+    : _file_path{make_absolute_path(desc.path)}
+    , _header{read_header(_file_path)}
+    , _physical_pages_per_side{desc.physical_pages_per_side}
+    , _feedback_downscale{std::max(desc.feedback_downscale, 1)}
+    , _max_uploads_per_frame{desc.max_uploads_per_frame}
+    , _page_table{
+          TextureSource::EmptyImage{
+              .width          = static_cast<GLsizei>(pages_count_x(0)),
+              .height         = static_cast<GLsizei>(pages_count_y(0)),
+              .texture_format = InternalFormatSized::RGBA8UI,
+              .levels_count   = static_cast<GLsizei>(_header.levels_count),
+          },
+          TextureOptions{
+              .minification_filter  = Filter::NearestNeighbour, // Integer textures can't be filtered
+              .magnification_filter = Filter::NearestNeighbour,
+          }
+      }
+    , _physical_texture{
+          TextureSource::EmptyImage{
+              .width          = desc.physical_pages_per_side * static_cast<GLsizei>(padded_page_size()),
+              .height         = desc.physical_pages_per_side * static_cast<GLsizei>(padded_page_size()),
+              .texture_format = InternalFormatSized::RGBA8,
+          },
+          TextureOptions{
+              .minification_filter  = Filter::Linear,
+              .magnification_filter = Filter::Linear,
+          }
+      }
+    , _feedback_shader{{
+          .vertex   = ShaderSource::File{"res/vertex.glsl"},
+          .fragment = ShaderSource::File{"res/virtual_texture_feedback.frag"},
+      }}
+{
+    assert(desc.physical_pages_per_side > 0 && desc.physical_pages_per_side <= 256 && "The page table stores the physical position of the pages on 8 bits.");
+
+    { // Read the position of all the pages in the file
+        auto pages_count = size_t{0};
+        for (uint32_t level = 0; level < _header.levels_count; ++level)
+        {
+            _first_page_of_level.push_back(pages_count);
+            pages_count += static_cast<size_t>(pages_count_x(level)) * pages_count_y(level);
+        }
+        _pages_offsets.resize(pages_count);
+        auto file = std::ifstream{_file_path, std::ios::binary};
+        file.seekg(sizeof(internal::VirtualTextureFileHeader));
+        file.read(reinterpret_cast<char*>(_pages_offsets.data()), static_cast<std::streamsize>(pages_count * sizeof(uint64_t))); // NOLINT(*reinterpret-cast)
+        if (!file)
+            handle_error(std::format("Virtual texture file \"{}\" is truncated.", _file_path.string()));
+
+        _page_table_levels.resize(_header.levels_count);
+        for (uint32_t level = 0; level < _header.levels_count; ++level)
+            _page_table_levels[level].resize(static_cast<size_t>(pages_count_x(level)) * pages_count_y(level));
+    }
+
+    for (auto slot = static_cast<uint32_t>(pages_capacity()); slot > 0; --slot)
+        _free_slots.push_back(slot - 1);
+
+    { // The coarsest level is a single page that always stays resident, so that there is always something to display
+        auto       file     = std::ifstream{_file_path, std::ios::binary};
+        auto const top_page = PageId{.level = _header.levels_count - 1, .x = 0, .y = 0};
+        if (!make_page_resident({.id = top_page, .texels = read_page(file, top_page)}, true /*locked*/))
+            handle_error(std::format("Failed to read the pages of virtual texture \"{}\".", _file_path.string()));
+    }
+    rebuild_page_table();
+
+    _streaming_thread = std::jthread{[this](std::stop_token const& stop_token) {
+        streaming_thread_loop(stop_token);
+    }};
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    if (_feedback_fence != nullptr)
+        glDeleteSync(_feedback_fence);
+}
+
+auto VirtualTexture::pages_count_x(uint32_t level) const -> uint32_t
+{
+    return std::max((_header.padded_width / _header.page_size) >> level, 1u);
+}
+
+auto VirtualTexture::pages_count_y(uint32_t level) const -> uint32_t
+{
+    return std::max((_header.padded_height / _header.page_size) >> level, 1u);
+}
+
+auto VirtualTexture::read_page(std::ifstream& file, PageId const& id) const -> std::vector<uint8_t>
+{
+    auto texels = std::vector<uint8_t>(static_cast<size_t>(padded_page_size()) * padded_page_size() * 4);
+    file.seekg(static_cast<std::streamoff>(_pages_offsets[_first_page_of_level[id.level] + static_cast<size_t>(id.y) * pages_count_x(id.level) + id.x]));
+    file.read(reinterpret_cast<char*>(texels.data()), static_cast<std::streamsize>(texels.size())); // NOLINT(*reinterpret-cast)
+    if (!file)
+    {
+        file.clear();
+        return {}; // We can't throw from the streaming thread, the page will just never become resident
+    }
+    return texels;
+}
+
+void VirtualTexture::streaming_thread_loop(std::stop_token const& stop_token)
+{
+    auto file = std::ifstream{_file_path, std::ios::binary};
+    while (true)
+    {
+        auto page = PageId{};
+        {
+            auto lock = std::unique_lock{_mutex};
+            if (!_requests_changed.wait(lock, stop_token, [&]() { return !_requested_pages.empty(); }))
+                return; // Stop has been requested
+            page = _requested_pages.front();
+            _requested_pages.erase(_requested_pages.begin());
+            _page_being_loaded = page.key();
+        }
+        auto texels = read_page(file, page);
+        {
+            auto lock = std::unique_lock{_mutex};
+            _loaded_pages.push_back({.id = page, .texels = std::move(texels)});
+            _page_being_loaded.reset();
+        }
+    }
+}
+
+void VirtualTexture::render_feedback(GLsizei screen_width, GLsizei screen_height, std::function<void(Shader const&)> const& draw_scene)
+{
+    if (_feedback_fence != nullptr) // update() hasn't received the previous feedback yet, there is no point in rendering a new one
+        return;
+
+    auto const width  = std::max(screen_width / _feedback_downscale, 1);
+    auto const height = std::max(screen_height / _feedback_downscale, 1);
+    if (!_feedback_target.has_value())
+    {
+        _feedback_target.emplace(RenderTarget_Descriptor{
+            .width          = width,
+            .height         = height,
+            .color_textures = {
+                ColorAttachment_Descriptor{
+                    .format  = InternalFormat_Color::RGBA16UI,
+                    .options = {
+                        .minification_filter  = Filter::NearestNeighbour,
+                        .magnification_filter = Filter::NearestNeighbour,
+                    },
+                },
+            },
+            .depth_stencil_texture = DepthStencilAttachment_Descriptor{
+                .format = InternalFormat_DepthStencil::Depth24,
+            },
+        });
+    }
+    else if (_feedback_target->width() != width || _feedback_target->height() != height)
+    {
+        _feedback_target->resize(width, height);
+    }
+
+    _feedback_target->render([&]() {
+        static constexpr std::array<GLuint, 4> no_page_requested{0, 0, 0, 0};
+        glClearBufferuiv(GL_COLOR, 0, no_page_requested.data());
+        glClear(GL_DEPTH_BUFFER_BIT);
+        _feedback_shader.bind();
+        _feedback_shader.set_uniform("virtual_size", glm::vec2{_header.padded_width, _header.padded_height});
+        _feedback_shader.set_uniform("uv_scale", glm::vec2{_header.width, _header.height} / glm::vec2{_header.padded_width, _header.padded_height});
+        _feedback_shader.set_uniform("page_size", static_cast<float>(_header.page_size));
+        _feedback_shader.set_uniform("max_level", static_cast<float>(_header.levels_count - 1));
+        _feedback_shader.set_uniform("mip_bias", -std::log2(static_cast<float>(_feedback_downscale))); // The derivatives are bigger because we render at a lower resolution
+        draw_scene(_feedback_shader);
+    });
+
+    // Copy the feedback into a Pixel Buffer Object, so that we don't wait for the GPU to finish rendering it. update() will read it once the fence is signaled.
+    _feedback_texels.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+    auto const size = static_cast<GLsizeiptr>(_feedback_texels.size() * sizeof(uint16_t));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _feedback_pixel_buffer.id());
+    if (_feedback_pixel_buffer_capacity < size)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        _feedback_pixel_buffer_capacity = size;
+    }
+    GLState::bind_texture(0, _feedback_target->color_texture(0).id());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr); // Writes into the bound GL_PIXEL_PACK_BUFFER, so it returns immediately
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    _feedback_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+auto VirtualTexture::read_feedback() -> bool
+{
+    if (_feedback_fence == nullptr)
+        return false;
+    auto const status = glClientWaitSync(_feedback_fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+        return false; // Not ready yet
+    glDeleteSync(_feedback_fence);
+    _feedback_fence = nullptr;
+    if (status == GL_WAIT_FAILED)
+        return false; // The next render_feedback() will try again
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _feedback_pixel_buffer.id());
+    auto const size = static_cast<GLsizeiptr>(_feedback_texels.size() * sizeof(uint16_t));
+    if (void const* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT))
+    {
+        std::memcpy(_feedback_texels.data(), mapped, static_cast<size_t>(size));
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+    {
+        std::fill(_feedback_texels.begin(), _feedback_texels.end(), uint16_t{0});
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+auto VirtualTexture::available_slots_count() const -> size_t
+{
+    // The pages used by the last feedback are at the front of the LRU, so the ones we can evict are all at the back
+    auto count = _free_slots.size();
+    for (auto it = _lru.rbegin(); it != _lru.rend() && _resident_pages.at(*it).last_used_frame < _frame_index; ++it)
+        ++count;
+    return count;
+}
+
+void VirtualTexture::update()
+{
+    auto       requested_pages  = std::vector<PageId>{};
+    bool const has_new_feedback = read_feedback();
+    if (has_new_feedback)
+    {
+        ++_frame_index;
+        auto visited = std::unordered_set<uint64_t>{};
+        for (size_t i = 0; i < _feedback_texels.size(); i += 4)
+        {
+            if (_feedback_texels[i + 3] == 0) // Nothing was rendered on this pixel
+                continue;
+            auto page = PageId{.level = _feedback_texels[i + 2], .x = _feedback_texels[i + 0], .y = _feedback_texels[i + 1]};
+            if (page.level >= _header.levels_count || page.x >= pages_count_x(page.level) || page.y >= pages_count_y(page.level))
+                continue;
+            // Also request the missing parents, so that the image gets refined progressively
+            while (visited.insert(page.key()).second)
+            {
+                auto const it = _resident_pages.find(page.key());
+                if (it != _resident_pages.end())
+                {
+                    it->second.last_used_frame = _frame_index;
+                    if (!it->second.is_locked)
+                        _lru.splice(_lru.begin(), _lru, it->second.lru_position);
+                    break;
+                }
+                requested_pages.push_back(page);
+                if (page.level + 1 >= _header.levels_count)
+                    break;
+                page = PageId{.level = page.level + 1, .x = page.x / 2, .y = page.y / 2};
+            }
+        }
+        // Load the coarsest pages first
+        std::stable_sort(requested_pages.begin(), requested_pages.end(), [](PageId const& a, PageId const& b) {
+            return a.level > b.level;
+        });
+    }
+
+    auto loaded_pages = std::vector<LoadedPage>{};
+    {
+        auto lock = std::unique_lock{_mutex};
+        if (has_new_feedback) // Otherwise we keep the requests of the last feedback
+        {
+            std::erase_if(requested_pages, [&](PageId const& page) {
+                return page.key() == _page_being_loaded
+                       || std::any_of(_loaded_pages.begin(), _loaded_pages.end(), [&](LoadedPage const& loaded) { return loaded.id.key() == page.key(); });
+            });
+            // Don't load pages that we have no room for: they would be thrown away by make_page_resident() and read from the disk again on the next frame.
+            // The coarsest pages come first, so they are the ones we keep.
+            auto const pending_pages_count = _loaded_pages.size() + (_page_being_loaded.has_value() ? 1 : 0);
+            auto const slots_count         = available_slots_count();
+            requested_pages.resize(std::min(requested_pages.size(), slots_count > pending_pages_count ? slots_count - pending_pages_count : 0));
+            _requested_pages = std::move(requested_pages); // The pages that are not visible anymore are not worth loading
+        }
+        auto const uploads_count = std::min(_loaded_pages.size(), _max_uploads_per_frame);
+        std::move(_loaded_pages.begin(), _loaded_pages.begin() + static_cast<std::ptrdiff_t>(uploads_count), std::back_inserter(loaded_pages));
+        _loaded_pages.erase(_loaded_pages.begin(), _loaded_pages.begin() + static_cast<std::ptrdiff_t>(uploads_count));
+    }
+    _requests_changed.notify_one();
+
+    for (auto const& page : loaded_pages)
+        make_page_resident(page, false /*locked*/);
+
+    if (_page_table_is_dirty)
+        rebuild_page_table();
+}
+
+auto VirtualTexture::make_page_resident(LoadedPage const& page, bool locked) -> bool
+{
+    if (page.texels.empty() || _resident_pages.contains(page.id.key()))
+        return false;
+
+    uint32_t slot{};
+    if (!_free_slots.empty())
+    {
+        slot = _free_slots.back();
+        _free_slots.pop_back();
+    }
+    else
+    {
+        if (_lru.empty())
+            return false;
+        auto const victim = _resident_pages.find(_lru.back());
+        if (victim->second.last_used_frame >= _frame_index) // All the pages in the cache are visible, we don't have room for this one
+            return false;
+        slot = victim->second.slot;
+        _lru.pop_back();
+        _resident_pages.erase(victim);
+    }
+
+    auto const size = static_cast<GLsizei>(padded_page_size());
+    GLState::bind_texture(0, _physical_texture.id());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(slot % static_cast<uint32_t>(_physical_pages_per_side)) * size, static_cast<GLint>(slot / static_cast<uint32_t>(_physical_pages_per_side)) * size, size, size, GL_RGBA, GL_UNSIGNED_BYTE, page.texels.data());
+
+    if (!locked)
+        _lru.push_front(page.id.key());
+    _resident_pages[page.id.key()] = ResidentPage{
+        .slot            = slot,
+        .lru_position    = locked ? _lru.end() : _lru.begin(),
+        .last_used_frame = _frame_index,
+        .is_locked       = locked,
+    };
+    _page_table_is_dirty = true;
+    return true;
+}
+
+void VirtualTexture::rebuild_page_table()
+{
+    auto const pages_per_side = static_cast<uint32_t>(_physical_pages_per_side);
+    GLState::bind_texture(0, _page_table.id());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // Go from the coarsest to the finest level, so that pages that are not resident can use the entry of their parent
+    for (auto level = static_cast<int64_t>(_header.levels_count) - 1; level >= 0; --level)
+    {
+        auto const current_level = static_cast<uint32_t>(level);
+        auto&      entries       = _page_table_levels[current_level];
+        for (uint32_t y = 0; y < pages_count_y(current_level); ++y)
+        {
+            for (uint32_t x = 0; x < pages_count_x(current_level); ++x)
+            {
+                auto const it    = _resident_pages.find(PageId{.level = current_level, .x = x, .y = y}.key());
+                auto&      entry = entries[static_cast<size_t>(y) * pages_count_x(current_level) + x];
+                if (it != _resident_pages.end())
+                    entry = pack_page_table_entry(it->second.slot % pages_per_side, it->second.slot / pages_per_side, current_level);
+                else if (current_level + 1 < _header.levels_count)
+                    entry = _page_table_levels[current_level + 1][static_cast<size_t>(y / 2) * pages_count_x(current_level + 1) + x / 2];
+                else
+                    entry = 0;
+            }
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(current_level), 0, 0, static_cast<GLsizei>(pages_count_x(current_level)), static_cast<GLsizei>(pages_count_y(current_level)), GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, entries.data());
+    }
+    _page_table_is_dirty = false;
+}
+
+void VirtualTexture::set_uniform(Shader const& shader, std::string_view uniform_name) const
+{
+    auto const physical_size = static_cast<float>(_physical_pages_per_side * static_cast<GLsizei>(padded_page_size()));
+    shader.set_uniform(std::format("{}.page_table", uniform_name), _page_table);
+    shader.set_uniform(std::format("{}.physical_texture", uniform_name), _physical_texture);
+    shader.set_uniform(std::format("{}.virtual_size", uniform_name), glm::vec2{_header.padded_width, _header.padded_height});
+    shader.set_uniform(std::format("{}.uv_scale", uniform_name), glm::vec2{_header.width, _header.height} / glm::vec2{_header.padded_width, _header.padded_height});
+    shader.set_uniform(std::format("{}.page_size", uniform_name), static_cast<float>(_header.page_size));
+    shader.set_uniform(std::format("{}.border", uniform_name), static_cast<float>(_header.border));
+    shader.set_uniform(std::format("{}.max_level", uniform_name), static_cast<float>(_header.levels_count - 1));
+    shader.set_uniform(std::format("{}.physical_size", uniform_name), glm::vec2{physical_size});
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <img/img.hpp>
+#include "Buffer.hpp"
+#include "RenderTarget.hpp"
+#include "Shader.hpp"
+#include "Texture.hpp"
+
+namespace internal {
+struct VirtualTextureFileHeader {
+    std::array<char, 4> magic{};
+    uint32_t            version{};
+    uint32_t            width{};         // Size of the original image
+    uint32_t            height{};        //
+    uint32_t            padded_width{};  // Size of the image once padded to a power-of-two number of pages
+    uint32_t            padded_height{}; //
+    uint32_t            page_size{};
+    uint32_t            border{};
+    uint32_t            levels_count{};
+};
+} // namespace internal
+
+/// Converts an image into the tiled format read by VirtualTexture (a ".vtex" file).
+/// This is an offline step: the whole image and its mipmaps are held in memory while baking.
+/// @param image Must have 4 channels (RGBA).
+/// @param page_size Size (in texels) of the content of a page, without its border.
+/// @param border Number of texels duplicated from the neighbouring pages around each page, so that bilinear filtering doesn't bleed between pages of the physical texture.
+void write_virtual_texture_file(img::Image const& image, std::filesystem::path const& file_path, uint32_t page_size = 128, uint32_t border = 4);
+
+struct VirtualTexture_Descriptor {
+    std::filesystem::path path{};                      /// A file created with write_virtual_texture_file()
+    GLsizei               physical_pages_per_side{16}; /// The physical texture holds physical_pages_per_side * physical_pages_per_side pages. Must be <= 256.
+    GLsizei               feedback_downscale{8};       /// The feedback pass is rendered at (screen resolution / feedback_downscale).
+    size_t                max_uploads_per_frame{16};   /// Limits the number of pages copied to the GPU each frame, to avoid hitches.
+};
+
+/// A texture that can be much bigger than the GPU (and CPU) memory.
+/// Only the pages that are actually visible are streamed from the disk, and kept in a fixed-size physical texture (an LRU cache).
+/// Each frame you need to:
+///   - call render_feedback(), drawing your scene with the feedback shader, to know which pages are visible
+///   - call update(), which requests the missing pages, uploads the pages that have finished loading and updates the page table
+///   - call set_uniform() on the shader that samples the texture (see res/virtual_texture.frag)
+class VirtualTexture {
+public:
+    explicit VirtualTexture(VirtualTexture_Descriptor const&);
+    ~VirtualTexture();
+    VirtualTexture(VirtualTexture const&)                    = delete; // The streaming thread references this object,
+    auto operator=(VirtualTexture const&) -> VirtualTexture& = delete; // so it can be neither copied
+    VirtualTexture(VirtualTexture&&)                         = delete; // nor moved.
+    auto operator=(VirtualTexture&&) -> VirtualTexture&      = delete;
+
+    /// Renders the scene into the (low-resolution) feedback target, and starts reading it back into a Pixel Buffer Object.
+    /// draw_scene must draw all the meshes that use this texture. The feedback shader is bound when it is called, and you must set its "model_view_projection" uniform.
+    /// Does nothing while the previous readback is still in flight.
+    void render_feedback(GLsizei screen_width, GLsizei screen_height, std::function<void(Shader const& feedback_shader)> const& draw_scene);
+    /// Reads the result of the last render_feedback() if the GPU has finished it (never blocks), streams the missing pages and updates the page table.
+    void update();
+
+    /// Sets all the uniforms of a `uniform VirtualTexture name;` declared as in res/virtual_texture.frag.
+    /// The shader must be bound.
+    void set_uniform(Shader const& shader, std::string_view uniform_name) const;
+
+    auto resident_pages_count() const -> size_t { return _resident_pages.size(); }
+    auto pages_capacity() const -> size_t { return static_cast<size_t>(_physical_pages_per_side * _physical_pages_per_side); }
+
+private:
+    struct PageId {
+        uint32_t level{};
+        uint32_t x{};
+        uint32_t y{};
+
+        auto key() const -> uint64_t { return (static_cast<uint64_t>(level) << 48) | (static_cast<uint64_t>(y) << 24) | x; }
+    };
+    struct ResidentPage {
+        uint32_t                      slot{};
+        std::list<uint64_t>::iterator lru_position{};
+        uint64_t                      last_used_frame{};
+        bool                          is_locked{false}; // Locked pages are never evicted
+    };
+    struct LoadedPage {
+        PageId               id{};
+        std::vector<uint8_t> texels{};
+    };
+
+    auto pages_count_x(uint32_t level) const -> uint32_t;
+    auto pages_count_y(uint32_t level) const -> uint32_t;
+    auto padded_page_size() const -> uint32_t { return _header.page_size + 2 * _header.border; }
+    auto read_page(std::ifstream& file, PageId const& id) const -> std::vector<uint8_t>;
+    auto make_page_resident(LoadedPage const&, bool locked) -> bool;
+    /// Returns false if the GPU hasn't finished copying the feedback into _feedback_pixel_buffer yet.
+    auto read_feedback() -> bool;
+    /// Number of pages that could become resident without evicting a page that is visible.
+    auto available_slots_count() const -> size_t;
+    void rebuild_page_table();
+    void streaming_thread_loop(std::stop_token const&);
+
+private:
+    std::filesystem::path              _file_path;
+    internal::VirtualTextureFileHeader _header;
+    std::vector<uint64_t>              _pages_offsets{}; // Position of each page in the file, level after level, row after row
+    std::vector<size_t>                _first_page_of_level{};
+
+    GLsizei _physical_pages_per_side;
+    GLsizei _feedback_downscale;
+    size_t  _max_uploads_per_frame;
+
+    Texture                            _page_table;
+    Texture                            _physical_texture;
+    std::vector<std::vector<uint32_t>> _page_table_levels{}; // CPU copy of the page table, RGBA8: (physical page x, physical page y, level of the page, 1)
+    bool                               _page_table_is_dirty{true};
+
+    Shader                      _feedback_shader;
+    std::optional<RenderTarget> _feedback_target{};
+    internal::UniqueBuffer      _feedback_pixel_buffer{};
+    GLsizeiptr                  _feedback_pixel_buffer_capacity{0};
+    GLsync                      _feedback_fence{nullptr}; // Set while a readback is in flight
+    std::vector<uint16_t>       _feedback_texels{};
+
+    std::unordered_map<uint64_t, ResidentPage> _resident_pages{};
+    std::list<uint64_t>                        _lru{}; // Most recently used at the front
+    std::vector<uint32_t>                      _free_slots{};
+    uint64_t                                   _frame_index{0}; // Incremented each time a feedback is read, so "visible" means "visible in the last feedback"
+
+    // Shared with the streaming thread
+    std::mutex                  _mutex{};
+    std::condition_variable_any _requests_changed{};
+    std::vector<PageId>         _requested_pages{}; // By order of priority, the first one is loaded first
+    std::optional<uint64_t>     _page_being_loaded{};
+    std::vector<LoadedPage>     _loaded_pages{};
+    std::jthread                _streaming_thread{}; // Must be declared last, so that it is stopped before the other members are destroyed
+};
@@ -0,0 +1,137 @@
+#include "WavefrontPathTracer.hpp"
+#include <cassert>
+
+// Must match "res/wavefront.glsl"
+static constexpr size_t path_size_in_bytes{64}; // sizeof(Path) in std430
+static constexpr size_t hit_size_in_bytes{128}; // sizeof(Ray) in std430
+static constexpr size_t queues_count{4};
+static constexpr size_t active_queue{0};
+static constexpr size_t refractive_queue{2};
+static constexpr size_t surface_queue{3};
+static constexpr int    after_intersect{0};
+static constexpr int    after_shade{1};
+
+static auto create_stage(std::filesystem::path const& path, std::vector<ShaderDefine> const& defines) -> ComputeShader
+{
+    return ComputeShader::create_async({.compute = ShaderSource::File{path}, .defines = defines});
+}
+
+WavefrontPathTracer::WavefrontPathTracer(WavefrontPathTracer_Descriptor const& desc)
+    : _desc{desc}
+    , _generate{create_stage("res/wavefront_generate.comp", desc.defines)}
+    , _intersect{create_stage("res/wavefront_intersect.comp", desc.defines)}
+    , _shade{create_stage("res/wavefront_shade.comp", desc.defines)}
+    , _prepare{create_stage("res/wavefront_prepare.comp", desc.defines)}
+    , _accumulate{create_stage("res/wavefront_accumulate.comp", desc.defines)}
+    , _queue_counts{queues_count * sizeof(GLuint)}
+    , _dispatch_args{queues_count * sizeof(glm::uvec4)}
+{
+    assert(desc.samples_count >= 1 && desc.max_bounces >= 1);
+}
+
+void WavefrontPathTracer::allocate(glm::ivec2 size)
+{
+    auto const paths_count = static_cast<size_t>(size.x) * static_cast<size_t>(size.y);
+    _size                  = size;
+    _paths.emplace(paths_count * path_size_in_bytes);
+    _hits.emplace(paths_count * hit_size_in_bytes);
+    _radiance.emplace(paths_count * sizeof(glm::vec4));
+    for (auto& queue : _active_queues)
+        queue.emplace(paths_count * sizeof(GLuint));
+    _refractive_queue.emplace(paths_count * sizeof(GLuint));
+    _surface_queue.emplace(paths_count * sizeof(GLuint));
+    _accumulation.emplace(TextureSource::EmptyImage{.width = size.x, .height = size.y, .texture_format = InternalFormatSized::RGBA32F});
+    _bright_pixels.emplace(TextureSource::EmptyImage{.width = size.x, .height = size.y, .texture_format = InternalFormatSized::RGBA16F});
+}
+
+void WavefrontPathTracer::bind_buffers(Shader const& stage) const
+{
+    // Each program has its own binding points, so we need to bind them again for each stage
+    stage.set_storage_buffer("Paths", *_paths);
+    stage.set_storage_buffer("Hits", *_hits);
+    stage.set_storage_buffer("Radiance", *_radiance);
+    stage.set_storage_buffer("QueueCounts", _queue_counts);
+    stage.set_storage_buffer("DispatchArgs", _dispatch_args);
+    stage.set_storage_buffer("ActiveQueue", *_active_queues[_current_active_queue]);
+    stage.set_storage_buffer("NextActiveQueue", *_active_queues[1 - _current_active_queue]);
+    stage.set_storage_buffer("RefractiveQueue", *_refractive_queue);
+    stage.set_storage_buffer("SurfaceQueue", *_surface_queue);
+}
+
+void WavefrontPathTracer::prepare_next_stage(int stage)
+{
+    _prepare.bind();
+    bind_buffers(_prepare);
+    _prepare.set_uniform("stage", stage);
+    _prepare.dispatch({1, 1, 1});
+    memory_barrier(Barrier::ShaderStorage | Barrier::Command);
+}
+
+void WavefrontPathTracer::render(glm::ivec2 size, uint32_t frame_index, LowDiscrepancySampler const& sampler, std::function<void(Shader const&)> const& set_scene_uniforms)
+{
+    if (size != _size || !_paths)
+        allocate(size);
+
+    // The uniforms are stored in each program, so we only need to set them once per frame
+    for (auto const* stage : {&_generate, &_intersect, &_shade, &_accumulate})
+    {
+        stage->bind();
+        set_scene_uniforms(*stage);
+        sampler.set_uniforms(*stage, frame_index);
+        stage->set_uniform("resolution", glm::vec2{size});
+        stage->set_uniform("NUMBER_OF_SAMPLES", static_cast<float>(_desc.samples_count));
+        stage->set_uniform("MAX_REFLECTIONS", static_cast<float>(_desc.max_bounces));
+    }
+
+    for (int sample = 0; sample < _desc.samples_count; ++sample)
+    {
+        _current_active_queue = 0;
+        _generate.bind();
+        bind_buffers(_generate);
+        _generate.set_uniform("sampleInFrame", static_cast<GLuint>(sample)); // Must stay unsigned: sampleInFrame is a uint, which can only be set with glUniform1ui
+        _generate.dispatch_for_size({size, 1});
+        memory_barrier(Barrier::ShaderStorage | Barrier::Command);
+
+        // We don't know when all the paths are finished without reading the counts back, so we always do max_bounces iterations. The ones that have no path left dispatch 0 work groups.
+        for (int bounce = 0; bounce < _desc.max_bounces; ++bounce)
+        {
+            _intersect.bind();
+            bind_buffers(_intersect);
+            _intersect.dispatch_indirect(_dispatch_args, active_queue * sizeof(glm::uvec4));
+            memory_barrier(Barrier::ShaderStorage);
+            prepare_next_stage(after_intersect);
+
+            _shade.bind();
+            bind_buffers(_shade);
+            for (auto const queue : {refractive_queue, surface_queue})
+            {
+                _shade.set_storage_buffer("InputQueue", queue == refractive_queue ? *_refractive_queue : *_surface_queue);
+                _shade.set_uniform("inputQueueIndex", static_cast<int>(queue));
+                _shade.dispatch_indirect(_dispatch_args, queue * sizeof(glm::uvec4));
+            }
+            memory_barrier(Barrier::ShaderStorage);
+            prepare_next_stage(after_shade);
+            _current_active_queue = 1 - _current_active_queue;
+        }
+    }
+
+    _accumulate.bind();
+    bind_buffers(_accumulate);
+    _accumulate.set_uniform("framesStill", static_cast<float>(frame_index + 1));
+    _accumulate.set_image("accumulation", *_accumulation, InternalFormatSized::RGBA32F, ImageAccess::ReadWrite);
+    _accumulate.set_image("bloomColor", *_bright_pixels, InternalFormatSized::RGBA16F, ImageAccess::WriteOnly);
+    _accumulate.dispatch_for_size({size, 1});
+    memory_barrier(Barrier::TextureFetch | Barrier::ShaderImageAccess);
+}
+
+auto WavefrontPathTracer::texture() const -> Texture const&
+{
+    assert(_accumulation.has_value() && "You must call render() first.");
+    return *_accumulation;
+}
+
+auto WavefrontPathTracer::bright_pixels() const -> Texture const&
+{
+    assert(_bright_pixels.has_value() && "You must call render() first.");
+    return *_bright_pixels;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+#include "ComputeShader.hpp"
+#include "LowDiscrepancySampler.hpp"
+#include "StorageBuffer.hpp"
+#include "Texture.hpp"
+#include "glm/glm.hpp"
+
+struct WavefrontPathTracer_Descriptor {
+    int                       samples_count{1}; // Per pixel and per frame, like NUMBER_OF_SAMPLES in default.frag
+    int                       max_bounces{8};   // Like MAX_REFLECTIONS in default.frag
+    std::vector<ShaderDefine> defines{};        // Added to all the stages, e.g. {"NEXT_EVENT_ESTIMATION"} or {"PLANE_GRID"}, like for default.frag
+};
+
+/// Renders the same image as "res/default.frag", but splits the path tracing into stages that each run as a separate compute shader:
+/// generate the camera rays, intersect them with the scene, shade them (one pass per kind of material), and accumulate the result.
+/// Between the stages the state of each path is kept in storage buffers, and the paths are sorted into queues:
+/// the rays that hit a refractive object are shaded together, as are the ones that hit a diffuse / specular one, and the finished paths are removed.
+/// So the invocations that run together take the same branches, instead of diverging like in the single shader, where each pixel can hit a different material at each bounce.
+/// The number of paths in each queue stays on the GPU: the stages are dispatched with ComputeShader::dispatch_indirect().
+class WavefrontPathTracer {
+public:
+    explicit WavefrontPathTracer(WavefrontPathTracer_Descriptor const& = {});
+
+    /// Adds desc.samples_count samples per pixel to the accumulation. frame_index must be 0 to start the accumulation over (e.g. when the camera moves).
+    /// set_scene_uniforms is called once per stage with its shader, to let you set the uniforms of the scene (objects, camera, skybox, the LightSampler, etc.), like you would for default.frag.
+    /// The buffers are (re)allocated if the size changes.
+    void render(glm::ivec2 size, uint32_t frame_index, LowDiscrepancySampler const& sampler, std::function<void(Shader const&)> const& set_scene_uniforms);
+
+    /// The mean of the samples of each pixel
+    auto texture() const -> Texture const&;
+    /// The BloomColor output of default.frag
+    auto bright_pixels() const -> Texture const&;
+
+private:
+    void allocate(glm::ivec2 size);
+    void bind_buffers(Shader const&) const;
+    void prepare_next_stage(int stage);
+
+private:
+    WavefrontPathTracer_Descriptor              _desc;
+    ComputeShader                               _generate;
+    ComputeShader                               _intersect;
+    ComputeShader                               _shade;
+    ComputeShader                               _prepare;
+    ComputeShader                               _accumulate;
+    std::optional<StorageBuffer>                _paths{};
+    std::optional<StorageBuffer>                _hits{};
+    std::optional<StorageBuffer>                _radiance{};
+    std::array<std::optional<StorageBuffer>, 2> _active_queues{}; // The one that is read at the current bounce, and the one that is filled for the next bounce
+    std::optional<StorageBuffer>                _refractive_queue{};
+    std::optional<StorageBuffer>                _surface_queue{};
+    StorageBuffer                               _queue_counts;
+    StorageBuffer                               _dispatch_args;
+    std::optional<Texture>                      _accumulation{};
+    std::optional<Texture>                      _bright_pixels{};
+    glm::ivec2                                  _size{0};
+    size_t                                      _current_active_queue{0};
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+/// FNV-1a, 64 bits. Not cryptographic, but fast and good enough to identify files and cache entries.
+/// Pass the result of a previous call as seed to hash several strings as if they were concatenated.
+inline auto fnv1a(std::string_view data, uint64_t seed = 14695981039346656037ull) -> uint64_t
+{
+    uint64_t hash = seed;
+    for (char const c : data)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
@@ -1,8 +1,9 @@
 #include "framebuffer.h"
+#include "GLState.hpp"
 
 FrameBuffer::FrameBuffer(int attachments, GLuint tex1, GLuint tex2) {
 	glGenFramebuffers(1, &buf);
-	glBindFramebuffer(GL_FRAMEBUFFER, buf);
+	GLState::bind_framebuffer(GL_FRAMEBUFFER, buf);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex1, 0);
 
 	if (attachments == 2) {
@@ -13,9 +14,10 @@ FrameBuffer::FrameBuffer(int attachments, GLuint tex1, GLuint tex2) {
 }
 
 void FrameBuffer::Bind() {
-	glBindFramebuffer(GL_FRAMEBUFFER, buf);
+	GLState::bind_framebuffer(GL_FRAMEBUFFER, buf);
 }
 
 void FrameBuffer::Delete() {
 	glDeleteFramebuffers(1, &buf);
+	GLState::forget_framebuffer(buf);
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "lz4.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include "handle_error.hpp"
+
+static constexpr size_t min_match_length{4};
+static constexpr size_t last_literals_count{5}; // The last 5 bytes must always be literals
+static constexpr size_t match_safe_distance{12}; // The last match must start at least 12 bytes before the end
+static constexpr size_t max_offset{65535};
+static constexpr int    hash_bits{16};
+
+static auto read_u32(std::byte const* ptr) -> uint32_t
+{
+    uint32_t value; // NOLINT(*init-variables)
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static auto hash(uint32_t sequence) -> size_t
+{
+    return (sequence * 2654435761u) >> (32 - hash_bits);
+}
+
+/// Lengths that don't fit in 4 bits are continued with bytes of 255, ended by a byte smaller than 255
+static void write_length(std::vector<std::byte>& out, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        out.push_back(std::byte{255});
+    out.push_back(static_cast<std::byte>(length));
+}
+
+static void write_sequence(std::vector<std::byte>& out, std::span<std::byte const> literals, size_t match_length, size_t offset)
+{
+    auto const literals_nibble = std::min(literals.size(), size_t{15});
+    auto const match_nibble    = match_length == 0 ? 0 : std::min(match_length - min_match_length, size_t{15});
+    out.push_back(static_cast<std::byte>((literals_nibble << 4) | match_nibble));
+    if (literals_nibble == 15)
+        write_length(out, literals.size() - 15);
+    out.insert(out.end(), literals.begin(), literals.end());
+    if (match_length == 0) // Last sequence
+        return;
+    out.push_back(static_cast<std::byte>(offset & 0xFF));
+    out.push_back(static_cast<std::byte>(offset >> 8));
+    if (match_nibble == 15)
+        write_length(out, match_length - min_match_length - 15);
+}
+
+auto lz4_compress(std::span<std::byte const> data) -> std::vector<std::byte>
+{
+    auto out = std::vector<std::byte>{};
+    out.reserve(data.size() + data.size() / 255 + 16);
+
+    size_t literals_begin = 0;
+    if (data.size() > match_safe_distance)
+    {
+        auto       table     = std::vector<uint32_t>(size_t{1} << hash_bits, UINT32_MAX); // Last position at which each hash has been seen
+        auto const match_end = data.size() - last_literals_count;                         // Matches can't go further than that
+        size_t     position  = 0;
+        while (position + match_safe_distance <= data.size())
+        {
+            auto const sequence  = read_u32(data.data() + position);
+            auto&      entry     = table[hash(sequence)];
+            auto const candidate = static_cast<size_t>(entry);
+            entry                = static_cast<uint32_t>(position);
+            if (candidate == UINT32_MAX || position - candidate > max_offset || read_u32(data.data() + candidate) != sequence)
+            {
+                ++position;
+                continue;
+            }
+
+            auto length = min_match_length;
+            while (position + length < match_end && data[candidate + length] == data[position + length])
+                ++length;
+            // Extend the match backwards, over the literals we haven't written yet
+            auto start = position;
+            auto from  = candidate;
+            while (start > literals_begin && from > 0 && data[start - 1] == data[from - 1])
+            {
+                --start;
+                --from;
+                ++length;
+            }
+            write_sequence(out, data.subspan(literals_begin, start - literals_begin), length, start - from);
+            position       = start + length;
+            literals_begin = position;
+        }
+    }
+    write_sequence(out, data.subspan(literals_begin), 0, 0);
+    return out;
+}
+
+auto lz4_decompress(std::span<std::byte const> compressed, size_t original_size) -> std::vector<std::byte>
+{
+    auto       out      = std::vector<std::byte>(original_size);
+    size_t     in       = 0;
+    size_t     position = 0;
+    auto const corrupted = [&]() {
+        handle_error(std::format("Corrupted LZ4 data (at byte {} of {}).", in, compressed.size()));
+    };
+    auto const read_length = [&](size_t length) {
+        if (length != 15)
+            return length;
+        std::byte byte{};
+        do
+        {
+            if (in >= compressed.size())
+                corrupted();
+            byte = compressed[in++];
+            length += static_cast<size_t>(byte);
+        } while (byte == std::byte{255});
+        return length;
+    };
+
+    while (true)
+    {
+        if (in >= compressed.size())
+            corrupted();
+        auto const token           = static_cast<size_t>(compressed[in++]);
+        auto const literals_length = read_length(token >> 4);
+        if (literals_length > compressed.size() - in || literals_length > original_size - position)
+            corrupted();
+        if (literals_length != 0)
+            std::memcpy(out.data() + position, compressed.data() + in, literals_length);
+        in += literals_length;
+        position += literals_length;
+        if (in == compressed.size()) // The last sequence only has literals
+            break;
+
+        if (compressed.size() - in < 2)
+            corrupted();
+        auto const offset = static_cast<size_t>(compressed[in]) | (static_cast<size_t>(compressed[in + 1]) << 8);
+        in += 2;
+        auto const match_length = read_length(token & 0xF) + min_match_length;
+        if (offset == 0 || offset > position || match_length > original_size - position)
+            corrupted();
+        // The match can overlap with the bytes it is producing, so we must copy byte by byte
+        for (size_t i = 0; i < match_length; ++i, ++position)
+            out[position] = out[position - offset];
+    }
+    if (position != original_size)
+        corrupted();
+    return out;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/// Compresses data in the LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+/// LZ4 doesn't compress as well as deflate, but decompresses several times faster, which is what we care about for assets that are decompressed at each startup.
+auto lz4_compress(std::span<std::byte const> data) -> std::vector<std::byte>;
+
+/// Decompresses an LZ4 block. original_size must be the exact size of the data before compression.
+/// Calls handle_error() if the block is corrupted.
+auto lz4_decompress(std::span<std::byte const> compressed, size_t original_size) -> std::vector<std::byte>;
@@ -5,15 +5,12 @@
 
 #include <iostream>
 #include <string>
-#include <ctime>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/quaternion_transform.hpp>
 
 #include "ImGuiWrapper.h"
 
-void updateRandomSeeds(double[3], double[3]);
-
 /// This is an example of how you would create windows and widgets with ImGui.
 /// Replace it with your own code!
 void example_imgui_windows()
@@ -43,6 +40,7 @@ void example_imgui_windows()
         ImGui::Text("counter = %d", counter);
 
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+        ImGui::Text("GL calls: %llu, redundant calls skipped: %llu", static_cast<unsigned long long>(GLState::stats().calls_count), static_cast<unsigned long long>(GLState::stats().redundant_calls_count));
         ImGui::End();
     }
 
@@ -73,7 +71,7 @@ int main(int, char**)
         },
     });
 
-    glEnable(GL_DEPTH_TEST);
+    GLState::set_enabled(GL_DEPTH_TEST, true);
 
     auto const cube_mesh = Mesh{{
     .vertex_buffers = {{
@@ -161,29 +159,21 @@ int main(int, char**)
         .fragment = ShaderSource::File{"res/fragment.glsl"},
         //.vertex = ShaderSource::File{"res/default.vert"},
         //.fragment = ShaderSource::File{"res/default.frag"},
+        .hot_reload = true, // Edit the shader files while the app is running, and see the result immediately
     }};
 
     /*auto const shader2 = Shader{{
-        .vertex = ShaderSource::File{"res/default.vert"},
+        .vertex = ShaderSource::File{"res/fullscreen.vert"},
         .fragment = ShaderSource::File{"res/display.frag"},
     }};
 
     auto const shader3 = Shader{{
-        .vertex = ShaderSource::File{"res/default.vert"},
+        .vertex = ShaderSource::File{"res/fullscreen.vert"},
         .fragment = ShaderSource::File{"res/postProcess.frag"},
-    }};
-
-    auto const shader4 = Shader{{
-        .vertex = ShaderSource::File{"res/default.vert"},
-        .fragment = ShaderSource::File{"res/bloom.frag"},
     }};*/
 
     int frameStill = 0;
 
-    // random seeds
-    srand(static_cast<unsigned int>(time(nullptr))); // init random with time
-    double rSeed1[2], rSeed2[2];
-
     // Main loop
     while (ImGuiWrapper::window_is_open()) {
         ++frameStill;
@@ -196,8 +186,6 @@ int main(int, char**)
         // Title
         ImGuiWrapper::getTitle();
 
-        updateRandomSeeds(rSeed1, rSeed2);
-
         // ImGui Wrapper
         glClearColor(1.0f, .0f, .0f, .0f);
         //glClear(GL_COLOR_BUFFER_BIT);
@@ -205,6 +193,7 @@ int main(int, char**)
 
         ImGuiWrapper::begin_frame();
         example_imgui_windows();
+        ImGuiWrapper::shader_errors_window({shader});
         ImGuiWrapper::end_frame(/*ImVec4(1.0f, .0f, .0f, 1.00f)*/);
 
         glm::mat4 const view_matrix = camera.view_matrix();
@@ -233,8 +222,7 @@ int main(int, char**)
         shader.set_uniform("light_direction", glm::normalize(glm::vec3(1, 0.0, 0.0)));
         //shader.set_uniform("resolution", glm::vec2{ImGuiWrapper::framebuffer_width_in_pixels(), ImGuiWrapper::framebuffer_height_in_pixels()});
         //shader.set_uniform("framesStill", frameStill);
-        //shader.set_uniform("rSeed1", glm::vec2{rSeed1[0], rSeed1[1]});
-        //shader.set_uniform("rSeed2", glm::vec2{rSeed2[0], rSeed2[1]});
+        //sampler.set_uniforms(shader, static_cast<uint32_t>(frameStill - 1));
         //shader.set_uniform("treshHoldIntensity", );
 
         cube_mesh.draw();
@@ -243,11 +231,3 @@ int main(int, char**)
 
     ImGuiWrapper::shutdown();
 }
-
-void updateRandomSeeds(double rSeed1[3], double rSeed2[3]) {
-    rSeed1[0] = rand() % 10000 / 100.0;
-    rSeed1[1] = rand() % 10000 / 100.0;
-
-    rSeed2[0] = rand() % 10000 / 100.0;
-    rSeed2[1] = rand() % 10000 / 100.0;
-}
@@ -0,0 +1,52 @@
+// Packs asset files into an archive that read_asset() can read (see src/AssetArchive.hpp).
+// Usage: pack_assets <archive_path> <root_folder> <folder_or_file>...
+// Each folder_or_file is relative to root_folder, and folders are packed recursively. The assets are stored under their path relative to root_folder (e.g. "res/default.frag"),
+// which is how the renderer looks them up, so root_folder should be the folder that contains "res".
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+#include "AssetArchive.hpp"
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <archive_path> <root_folder> <folder_or_file>...\n";
+        return EXIT_FAILURE;
+    }
+    auto const archive_path = std::filesystem::absolute(argv[1]);
+    auto const root_folder  = std::filesystem::absolute(argv[2]); // write_asset_archive() resolves relative paths against the folder of this executable, not the current directory
+
+    try
+    {
+        auto asset_paths = std::vector<std::filesystem::path>{};
+        for (int i = 3; i < argc; ++i)
+        {
+            auto const path = root_folder / argv[i];
+            if (!std::filesystem::is_directory(path))
+            {
+                asset_paths.emplace_back(argv[i]);
+                continue;
+            }
+            for (auto const& entry : std::filesystem::recursive_directory_iterator{path})
+            {
+                if (entry.is_regular_file())
+                    asset_paths.push_back(entry.path().lexically_relative(root_folder));
+            }
+        }
+        std::sort(asset_paths.begin(), asset_paths.end()); // So that the archive doesn't depend on the order in which the file system lists the files
+
+        write_asset_archive(archive_path, root_folder, asset_paths);
+        std::cout << "Packed " << asset_paths.size() << " assets into " << archive_path.string() << '\n';
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}